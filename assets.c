@@ -0,0 +1,111 @@
+#include "assets.h"
+#include "mesh.h"
+#include "raymath.h"
+#include <stdio.h>
+#include <string.h>
+
+static CachedModel cachedModels[MAX_CACHED_MODELS];
+
+// Uploads a baked mesh straight from the mapping, one raylib mesh per level;
+// raylib only reads the arrays during upload
+static bool LoadBakedModel(const char *path, Model *model, int *lodCount) {
+    MappedMesh mapped;
+    if (!MapMeshBlob(path, &mapped)) return false;
+
+    *lodCount = mapped.header->lodCount;
+    *model = (Model){ 0 };
+    model->transform = MatrixIdentity();
+    model->meshCount = *lodCount;
+    model->meshes = RL_CALLOC(*lodCount, sizeof(Mesh));
+    model->meshMaterial = RL_CALLOC(*lodCount, sizeof(int));
+    model->materialCount = 1;
+    model->materials = RL_CALLOC(1, sizeof(Material));
+    model->materials[0] = LoadMaterialDefault();
+
+    for (int l = 0; l < *lodCount; l++) {
+        const MeshBlobLod *lod = &mapped.header->lods[l];
+        Mesh *mesh = &model->meshes[l];
+        mesh->vertexCount = lod->vertexCount;
+        mesh->triangleCount = lod->indexCount / 3;
+        mesh->vertices = (float *)(mapped.positions + lod->firstVertex * 3);
+        mesh->indices = (unsigned short *)(mapped.indices + lod->firstIndex);
+        UploadMesh(mesh, false);
+        // The arrays belong to the mapping, so UnloadModel must not free them
+        mesh->vertices = NULL;
+        mesh->indices = NULL;
+    }
+    UnmapMeshBlob(&mapped);
+    return true;
+}
+
+static bool LoadCachedModel(const char *path, Model *model, int *lodCount) {
+    char bakedPath[sizeof(cachedModels[0].path)];
+    const char *extension = strrchr(path, '.');
+    int stem = extension ? (int)(extension - path) : (int)strlen(path);
+    snprintf(bakedPath, sizeof(bakedPath), "%.*s.mesh", stem, path);
+    if (LoadBakedModel(bakedPath, model, lodCount)) return true;
+
+    *model = LoadModel(path);
+    *lodCount = 1;
+    return model->meshCount > 0;
+}
+
+static const CachedModel *FindCachedModel(const Model *model) {
+    for (int i = 0; i < MAX_CACHED_MODELS; i++) {
+        if (cachedModels[i].refCount > 0 && &cachedModels[i].model == model) return &cachedModels[i];
+    }
+    return NULL;
+}
+
+Model *AcquireModel(const char *path) {
+    CachedModel *freeEntry = NULL;
+    for (int i = 0; i < MAX_CACHED_MODELS; i++) {
+        CachedModel *entry = &cachedModels[i];
+        if (entry->refCount > 0 && strcmp(entry->path, path) == 0) {
+            entry->refCount++;
+            return &entry->model;
+        }
+        if (entry->refCount == 0 && !freeEntry) freeEntry = entry;
+    }
+    if (!freeEntry || strlen(path) >= sizeof(freeEntry->path)) return NULL;
+
+    if (!LoadCachedModel(path, &freeEntry->model, &freeEntry->lodCount)) return NULL;
+    strcpy(freeEntry->path, path);
+    freeEntry->refCount = 1;
+    return &freeEntry->model;
+}
+
+void ReleaseModel(Model *model) {
+    for (int i = 0; i < MAX_CACHED_MODELS; i++) {
+        CachedModel *entry = &cachedModels[i];
+        if (entry->refCount > 0 && &entry->model == model) {
+            if (--entry->refCount == 0) UnloadModel(entry->model);
+            return;
+        }
+    }
+}
+
+int GetModelLodCount(const Model *model) {
+    const CachedModel *entry = FindCachedModel(model);
+    return entry ? entry->lodCount : 1;
+}
+
+int SelectLod(int current, float distance, const float *distances, int lodCount) {
+    if (current < 0 || current >= lodCount) current = 0;
+    while (current < lodCount - 1 && distance > distances[current] * (1.0f + LOD_HYSTERESIS)) current++;
+    while (current > 0 && distance < distances[current - 1] * (1.0f - LOD_HYSTERESIS)) current--;
+    return current;
+}
+
+void DrawModelLod(const Model *model, int lod, Vector3 position, float scale, Color tint) {
+    if (GetModelLodCount(model) == 1) {
+        DrawModel(*model, position, scale, tint);
+        return;
+    }
+    // Draw just that level's mesh with the model's transform and material
+    Model level = *model;
+    level.meshes += lod;
+    level.meshMaterial += lod;
+    level.meshCount = 1;
+    DrawModel(level, position, scale, tint);
+}
@@ -0,0 +1,33 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include "raylib.h"
+
+#define MAX_CACHED_MODELS 16
+// A level only switches once the distance is this fraction past its threshold,
+// so boats sitting near a threshold don't flicker between levels
+#define LOD_HYSTERESIS 0.1f
+
+// One loaded model shared by everyone who asked for the same path
+typedef struct {
+    char path[256];
+    Model model;
+    int lodCount;          // baked models hold one mesh per level, full detail first
+    int refCount;
+} CachedModel;
+
+// Loads the model on first use and returns the shared copy afterwards. A baked
+// mesh next to the source (boat.obj -> boat.mesh) is mapped instead of parsing
+// the OBJ. Returns NULL when nothing could be loaded.
+Model *AcquireModel(const char *path);
+// Unloads the model once its last user releases it
+void ReleaseModel(Model *model);
+
+// Detail levels of a cached model; 1 when it was loaded from the OBJ
+int GetModelLodCount(const Model *model);
+// Level to draw at `distance` given the one drawn last frame. Level i + 1 takes
+// over past distances[i], so `distances` holds lodCount - 1 ascending thresholds.
+int SelectLod(int current, float distance, const float *distances, int lodCount);
+void DrawModelLod(const Model *model, int lod, Vector3 position, float scale, Color tint);
+
+#endif
@@ -0,0 +1,31 @@
+#include "mesh.h"
+#include <stdio.h>
+
+// Clustering grid resolution of each simplified level, coarser further down
+static const int lodResolutions[MESH_MAX_LODS - 1] = {24, 10};
+
+// Offline converter: parses an OBJ once and adds simplified levels of detail, so
+// the game can map the result instead
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        printf("Usage: %s input.obj output.mesh\n", argv[0]);
+        return 1;
+    }
+
+    MeshData lods[MESH_MAX_LODS];
+    if (!LoadObjMesh(argv[1], &lods[0])) {
+        fprintf(stderr, "Error: Could not read %s.\n", argv[1]);
+        return 1;
+    }
+    for (int l = 1; l < MESH_MAX_LODS; l++) {
+        SimplifyMesh(&lods[0], lodResolutions[l - 1], &lods[l]);
+    }
+
+    bool ok = WriteMeshBlob(argv[2], lods, MESH_MAX_LODS);
+    if (!ok) fprintf(stderr, "Error: Could not write %s.\n", argv[2]);
+    for (int l = 0; l < MESH_MAX_LODS; l++) {
+        if (ok) printf("%s LOD %d: %d vertices, %d triangles\n", argv[2], l, lods[l].vertexCount, lods[l].indexCount / 3);
+        FreeMeshData(&lods[l]);
+    }
+    return ok ? 0 : 1;
+}
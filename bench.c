@@ -0,0 +1,222 @@
+#include "sim.h"
+#include "profiler.h"
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Fixed seed so every run and every machine steps the same worlds
+#define BENCH_SEED 0xB0A7u
+// Boats are spread over this much of the water plane
+#define BENCH_SPREAD 180.0f
+#define BENCH_PI 3.14159265f
+
+static const int playerCounts[] = {10, 50, 100, 250, 500, 1000};
+static const int quickPlayerCounts[] = {10, 100, 1000};
+// Cannonballs each boat keeps in flight
+static const int shotCounts[] = {0, 10, MAX_CANNONBALLS};
+static const int quickShotCounts[] = {0, MAX_CANNONBALLS};
+
+// Growable list of samples for percentiles
+typedef struct {
+    uint32_t *values;
+    int count;
+    int capacity;
+} Samples;
+
+typedef struct {
+    int players;
+    int shots;
+    double boats;          // mean active boats over the timed ticks
+    double projectiles;    // mean cannonballs in flight over the timed ticks
+    uint32_t p50Ns, p99Ns;
+    double nsPerEntity;
+    double inputsUs, cannonballsUs, hitsUs;
+} BenchResult;
+
+static int64_t NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void AddSample(Samples *samples, uint32_t value) {
+    if (samples->count == samples->capacity) {
+        samples->capacity = samples->capacity ? samples->capacity * 2 : 1024;
+        samples->values = realloc(samples->values, samples->capacity * sizeof(uint32_t));
+    }
+    samples->values[samples->count++] = value;
+}
+
+static int CompareU32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples
+static uint32_t Percentile(const Samples *samples, double p) {
+    if (samples->count == 0) return 0;
+    int rank = (int)ceil(p / 100.0 * samples->count) - 1;
+    if (rank < 0) rank = 0;
+    return samples->values[rank];
+}
+
+static float RandomFloat(uint32_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return (*state >> 8) / 16777216.0f;
+}
+
+// Tops every boat up to `shots` cannonballs in flight and brings sunk boats straight
+// back, so the counts being measured hold for the whole run
+static void FeedInputs(Sim *sim, PlayerInput *inputs, int shots) {
+    for (int i = 0; i < sim->maxPlayers; i++) {
+        PlayerInput *input = &inputs[i];
+        const Player *player = &sim->players[i];
+        if (!player->active) {
+            // A disconnect and a connect on the next tick rejoin at full health
+            input->connected = !input->connected;
+        } else if (player->cannonballCount < shots) {
+            input->shots += shots - player->cannonballCount;
+        }
+        SubmitInput(sim, i, input);
+    }
+}
+
+static void RunBench(int players, int shots, int ticks, BenchResult *result) {
+    static Sim sim;
+    InitSim(&sim, SIM_DEFAULT_TICK_RATE, players);
+
+    uint32_t random = BENCH_SEED;
+    PlayerInput *inputs = calloc(players, sizeof(PlayerInput));
+    for (int i = 0; i < players; i++) {
+        float angle = RandomFloat(&random) * 2.0f * BENCH_PI;
+        inputs[i] = (PlayerInput){
+            .connected = true,
+            .position = {(RandomFloat(&random) - 0.5f) * 2.0f * BENCH_SPREAD, 0.0f, (RandomFloat(&random) - 0.5f) * 2.0f * BENCH_SPREAD},
+            .aim = {cosf(angle), 0.0f, sinf(angle)}
+        };
+    }
+
+    // Long enough for the first volleys to spread out over the plane
+    int warmup = ticks / 2;
+    Samples stepNs = {0};
+    double boats = 0.0, projectiles = 0.0;
+    for (int t = 0; t < warmup + ticks; t++) {
+        FeedInputs(&sim, inputs, shots);
+        // Keep warmup ticks, and the previous size's, out of the phase columns
+        if (t == warmup) ResetPhaseHistories();
+        int64_t start = NowNs();
+        StepSim(&sim);
+        int64_t elapsed = NowNs() - start;
+        if (t < warmup) continue;
+
+        AddSample(&stepNs, (uint32_t)elapsed);
+        projectiles += sim.projectiles.count;
+        for (int i = 0; i < players; i++) boats += sim.players[i].active;
+    }
+    qsort(stepNs.values, stepNs.count, sizeof(uint32_t), CompareU32);
+
+    // Means over the last PROFILE_HISTORY timed ticks, or all of them when there are fewer
+    PhaseStats inputStats, cannonballStats, hitStats;
+    GetPhaseStats(PHASE_TICK_INPUTS, &inputStats);
+    GetPhaseStats(PHASE_TICK_CANNONBALLS, &cannonballStats);
+    GetPhaseStats(PHASE_TICK_HITS, &hitStats);
+
+    *result = (BenchResult){
+        .players = players,
+        .shots = shots,
+        .boats = boats / ticks,
+        .projectiles = projectiles / ticks,
+        .p50Ns = Percentile(&stepNs, 50),
+        .p99Ns = Percentile(&stepNs, 99),
+        .inputsUs = inputStats.meanUs,
+        .cannonballsUs = cannonballStats.meanUs,
+        .hitsUs = hitStats.meanUs
+    };
+    result->nsPerEntity = result->p50Ns / (result->boats + result->projectiles);
+
+    free(stepNs.values);
+    free(inputs);
+    FreeSim(&sim);
+}
+
+static void PrintUsage(const char *program) {
+    printf("Usage: %s [--quick] [--ticks N] [--csv FILE]\n", program);
+    printf("  --quick  fewer sizes, for running as part of the build\n");
+    printf("  --ticks  timed ticks per size, after as many warmup ticks again (default %d)\n", PROFILE_HISTORY);
+    printf("  --csv    also write every result to FILE\n");
+}
+
+// Times StepSim alone, without threads, sockets or a window, for a range of
+// boat and cannonball counts
+int main(int argc, char **argv) {
+    bool quick = false;
+    int ticks = PROFILE_HISTORY;
+    const char *csvPath = NULL;
+
+    static const struct option options[] = {
+        {"quick", no_argument, NULL, 'q'},
+        {"ticks", required_argument, NULL, 't'},
+        {"csv", required_argument, NULL, 'c'},
+        {"help", no_argument, NULL, 'h'},
+        {0}
+    };
+    int option;
+    while ((option = getopt_long(argc, argv, "qt:c:h", options, NULL)) != -1) {
+        switch (option) {
+            case 'q': quick = true; break;
+            case 't': ticks = atoi(optarg); break;
+            case 'c': csvPath = optarg; break;
+            case 'h': PrintUsage(argv[0]); return 0;
+            default: PrintUsage(argv[0]); return 1;
+        }
+    }
+    if (ticks <= 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    FILE *csv = NULL;
+    if (csvPath) {
+        csv = fopen(csvPath, "w");
+        if (!csv) {
+            printf("Error: Could not write %s.\n", csvPath);
+            return 1;
+        }
+        fprintf(csv, "players,shots,boats,projectiles,step_p50_ns,step_p99_ns,ns_per_entity,inputs_us,cannonballs_us,hits_us\n");
+    }
+
+    const int *players = quick ? quickPlayerCounts : playerCounts;
+    int playerSizes = quick ? (int)(sizeof(quickPlayerCounts) / sizeof(int)) : (int)(sizeof(playerCounts) / sizeof(int));
+    const int *shots = quick ? quickShotCounts : shotCounts;
+    int shotSizes = quick ? (int)(sizeof(quickShotCounts) / sizeof(int)) : (int)(sizeof(shotCounts) / sizeof(int));
+
+    // One scaling curve per cannonball load: how the step grows with the boat count
+    printf("%7s %5s %8s %11s %10s %10s %9s %9s %9s %9s\n", "players", "shots", "boats", "cannonballs",
+           "p50 ns", "p99 ns", "ns/entity", "inputs", "move", "hits");
+    for (int s = 0; s < shotSizes; s++) {
+        for (int p = 0; p < playerSizes; p++) {
+            BenchResult result;
+            RunBench(players[p], shots[s], ticks, &result);
+            printf("%7d %5d %8.0f %11.0f %10u %10u %9.1f %8.1fus %7.1fus %7.1fus\n", result.players, result.shots,
+                   result.boats, result.projectiles, result.p50Ns, result.p99Ns, result.nsPerEntity,
+                   result.inputsUs, result.cannonballsUs, result.hitsUs);
+            if (csv) {
+                fprintf(csv, "%d,%d,%.1f,%.1f,%u,%u,%.2f,%.2f,%.2f,%.2f\n", result.players, result.shots, result.boats,
+                        result.projectiles, result.p50Ns, result.p99Ns, result.nsPerEntity, result.inputsUs,
+                        result.cannonballsUs, result.hitsUs);
+            }
+        }
+        printf("\n");
+    }
+
+    if (csv && fclose(csv) != 0) {
+        printf("Error: Could not write %s.\n", csvPath);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,316 @@
+#include "client.h"
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Sent inputs remembered per bot to match against its boat in later snapshots
+#define BOT_INPUT_HISTORY 128
+// A bot that hears nothing for this long counts as dropped
+#define BOT_SILENCE_TIMEOUT_MS 3000
+
+typedef struct {
+    int16_t x, z;          // quantized position the input carried
+    int64_t sentNs;
+} SentInput;
+
+typedef struct {
+    NetClient client;
+    bool connected;
+    bool dropped;
+    float angle;           // bots sail in circles around their own center
+    float radius;
+    Vec3 center;
+    PlayerInput input;
+    double shotBudget;
+    SentInput sent[BOT_INPUT_HISTORY];
+    uint32_t sentCount;
+    uint32_t matchedCount; // inputs before this are already accounted for
+    int64_t lastHeardNs;
+    uint32_t lastTick;
+} Bot;
+
+// Growable list of samples for percentiles
+typedef struct {
+    uint32_t *values;
+    int count;
+    int capacity;
+} Samples;
+
+typedef struct {
+    const char *host;
+    int port;
+    int botCount;
+    double duration;       // seconds of measurement after every bot connected
+    int sendRate;          // inputs per second per bot
+    double fireRate;       // shots per second per bot
+    const char *output;
+} BotOptions;
+
+static int64_t NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void AddSample(Samples *samples, uint32_t value) {
+    if (samples->count == samples->capacity) {
+        samples->capacity = samples->capacity ? samples->capacity * 2 : 1024;
+        samples->values = realloc(samples->values, samples->capacity * sizeof(uint32_t));
+    }
+    samples->values[samples->count++] = value;
+}
+
+static int CompareU32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples
+static uint32_t Percentile(const Samples *samples, double p) {
+    if (samples->count == 0) return 0;
+    int rank = (int)ceil(p / 100.0 * samples->count) - 1;
+    if (rank < 0) rank = 0;
+    return samples->values[rank];
+}
+
+static double Mean(const Samples *samples) {
+    if (samples->count == 0) return 0.0;
+    double sum = 0.0;
+    for (int i = 0; i < samples->count; i++) sum += samples->values[i];
+    return sum / samples->count;
+}
+
+static void WriteSamplesJson(FILE *file, const char *name, Samples *samples) {
+    qsort(samples->values, samples->count, sizeof(uint32_t), CompareU32);
+    fprintf(file, "  \"%s\": {\"count\": %d, \"mean\": %.1f, \"p50\": %u, \"p90\": %u, \"p99\": %u, \"max\": %u},\n", name,
+            samples->count, Mean(samples), Percentile(samples, 50), Percentile(samples, 90), Percentile(samples, 99),
+            samples->count ? samples->values[samples->count - 1] : 0);
+}
+
+static const NetEntity *FindBoat(const NetSnapshot *view, int playerId) {
+    int lo = 0, hi = view->count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        const NetEntity *entity = &view->entities[mid];
+        int order = (entity->kind != ENTITY_BOAT) ? 1 : (int)entity->id - playerId;
+        if (order == 0) return entity;
+        if (order < 0) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return NULL;
+}
+
+static void StepBot(Bot *bot, const BotOptions *options, int64_t now) {
+    float dt = 1.0f / options->sendRate;
+    bot->angle += dt * 0.5f;
+    bot->input.position = (BoatPosition){bot->center.x + cosf(bot->angle) * bot->radius, 0.0f,
+                                         bot->center.z + sinf(bot->angle) * bot->radius};
+    bot->input.aim = (Vec3){-sinf(bot->angle), 0.0f, cosf(bot->angle)};
+
+    bot->shotBudget += options->fireRate * dt;
+    while (bot->shotBudget >= 1.0) {
+        bot->input.shots++;
+        bot->shotBudget -= 1.0;
+    }
+
+    SentInput *sent = &bot->sent[bot->sentCount++ % BOT_INPUT_HISTORY];
+    sent->x = QuantizePosition(bot->input.position.x);
+    sent->z = QuantizePosition(bot->input.position.z);
+    sent->sentNs = now;
+    SendClientInput(&bot->client, &bot->input);
+}
+
+// Latency of the newest input the server has applied to this bot's boat, if it is a new one
+static bool MeasureLatency(Bot *bot, const NetSnapshot *view, int64_t now, uint32_t *latencyUs) {
+    const NetEntity *boat = FindBoat(view, bot->client.playerId);
+    if (!boat) return false;
+
+    uint32_t oldest = (bot->sentCount > BOT_INPUT_HISTORY) ? bot->sentCount - BOT_INPUT_HISTORY : 0;
+    if (bot->matchedCount > oldest) oldest = bot->matchedCount;
+    for (uint32_t i = bot->sentCount; i > oldest; i--) {
+        const SentInput *sent = &bot->sent[(i - 1) % BOT_INPUT_HISTORY];
+        if (sent->x == boat->position[0] && sent->z == boat->position[2]) {
+            bot->matchedCount = i;
+            *latencyUs = (uint32_t)((now - sent->sentNs) / 1000);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void PrintUsage(const char *program) {
+    printf("Usage: %s [options]\n", program);
+    printf("  --host IP        server address (default 127.0.0.1)\n");
+    printf("  --port N         server port (default 7777)\n");
+    printf("  --bots N         simulated clients, one socket each (default 10)\n");
+    printf("  --duration S     seconds to measure (default 10)\n");
+    printf("  --send-rate N    inputs per second per bot (default 60)\n");
+    printf("  --fire-rate F    shots per second per bot (default 1)\n");
+    printf("  --output FILE    JSON results (default bots.json)\n");
+}
+
+// Headless load generator: N bots sail and shoot against a server and report how it keeps up
+int main(int argc, char **argv) {
+    BotOptions options = {"127.0.0.1", 7777, 10, 10.0, 60, 1.0, "bots.json"};
+
+    static const struct option longOptions[] = {
+        {"host", required_argument, NULL, 'H'},
+        {"port", required_argument, NULL, 'p'},
+        {"bots", required_argument, NULL, 'n'},
+        {"duration", required_argument, NULL, 'd'},
+        {"send-rate", required_argument, NULL, 's'},
+        {"fire-rate", required_argument, NULL, 'f'},
+        {"output", required_argument, NULL, 'o'},
+        {"help", no_argument, NULL, 'h'},
+        {0}
+    };
+    int option;
+    while ((option = getopt_long(argc, argv, "H:p:n:d:s:f:o:h", longOptions, NULL)) != -1) {
+        switch (option) {
+            case 'H': options.host = optarg; break;
+            case 'p': options.port = atoi(optarg); break;
+            case 'n': options.botCount = atoi(optarg); break;
+            case 'd': options.duration = atof(optarg); break;
+            case 's': options.sendRate = atoi(optarg); break;
+            case 'f': options.fireRate = atof(optarg); break;
+            case 'o': options.output = optarg; break;
+            case 'h': PrintUsage(argv[0]); return 0;
+            default: PrintUsage(argv[0]); return 1;
+        }
+    }
+    if (options.botCount <= 0 || options.sendRate <= 0 || options.duration <= 0 || options.fireRate < 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    Bot *bots = calloc(options.botCount, sizeof(Bot));
+    int connectFailures = 0;
+    int64_t lastKeepAlive = NowNs();
+    srand(1);
+    for (int i = 0; i < options.botCount; i++) {
+        // Connecting hundreds of bots takes a while; keep the first ones from timing out meanwhile
+        if (NowNs() - lastKeepAlive > 100000000) {
+            lastKeepAlive = NowNs();
+            for (int j = 0; j < i; j++) {
+                if (bots[j].connected) SendClientInput(&bots[j].client, &bots[j].input);
+            }
+        }
+
+        Bot *bot = &bots[i];
+        bot->connected = ConnectClient(&bot->client, options.host, options.port);
+        if (!bot->connected) {
+            connectFailures++;
+            continue;
+        }
+        bot->center = (Vec3){(float)rand() / RAND_MAX * (WATER_WIDTH - 40) - (WATER_WIDTH - 40) / 2, 0.0f,
+                             (float)rand() / RAND_MAX * (WATER_LENGTH - 40) - (WATER_LENGTH - 40) / 2};
+        bot->radius = 5.0f + (float)rand() / RAND_MAX * 15.0f;
+        bot->angle = (float)rand() / RAND_MAX * 6.2831853f;
+        bot->input.connected = true;
+    }
+    printf("%d of %d bots connected\n", options.botCount - connectFailures, options.botCount);
+
+    // Only traffic of the measured run counts
+    for (int i = 0; i < options.botCount; i++) {
+        if (!bots[i].connected) continue;
+        PollClient(&bots[i].client);
+        InitLinkTelemetry(&bots[i].client.link, NowNs() / 1000000);
+        bots[i].lastHeardNs = NowNs();
+    }
+
+    Samples tickSamples = {0}, latencySamples = {0};
+    uint32_t lastSampledTick = 0, firstOverruns = 0, lastOverruns = 0;
+    bool haveTick = false;
+    int dropped = 0;
+
+    int64_t period = 1000000000 / options.sendRate;
+    int64_t start = NowNs();
+    int64_t end = start + (int64_t)(options.duration * 1e9);
+    int64_t next = start;
+
+    while (NowNs() < end) {
+        int64_t now = NowNs();
+        for (int i = 0; i < options.botCount; i++) {
+            Bot *bot = &bots[i];
+            if (!bot->connected || bot->dropped) continue;
+
+            StepBot(bot, &options, now);
+            PollClient(&bot->client);
+
+            const NetSnapshot *view = GetLatestView(&bot->client);
+            if (view && view->tick != bot->lastTick) {
+                bot->lastTick = view->tick;
+                bot->lastHeardNs = now;
+
+                uint32_t latencyUs;
+                if (MeasureLatency(bot, view, now, &latencyUs)) AddSample(&latencySamples, latencyUs);
+
+                // Every bot sees the same ticks; sample each server tick once
+                if (!haveTick || (int32_t)(view->tick - lastSampledTick) > 0) {
+                    if (!haveTick) firstOverruns = bot->client.serverOverruns;
+                    haveTick = true;
+                    lastSampledTick = view->tick;
+                    lastOverruns = bot->client.serverOverruns;
+                    AddSample(&tickSamples, bot->client.serverTickUs);
+                }
+            }
+
+            if (atomic_load(&bot->client.closed) || (now - bot->lastHeardNs) / 1000000 > BOT_SILENCE_TIMEOUT_MS) {
+                bot->dropped = true;
+                dropped++;
+            }
+        }
+
+        next += period;
+        int64_t sleepNs = next - NowNs();
+        if (sleepNs > 0) {
+            struct timespec ts = {sleepNs / 1000000000, sleepNs % 1000000000};
+            nanosleep(&ts, NULL);
+        } else {
+            next = NowNs();    // the bots can't keep up; don't try to catch up in a burst
+        }
+    }
+    double elapsed = (NowNs() - start) / 1e9;
+
+    uint64_t bytesReceived = 0, bytesSent = 0, packetsReceived = 0;
+    int measured = 0;
+    for (int i = 0; i < options.botCount; i++) {
+        if (!bots[i].connected) continue;
+        const LinkCounters *counters = &bots[i].client.link.counters;
+        bytesReceived += atomic_load_explicit(&counters->bytesReceived, memory_order_relaxed);
+        bytesSent += atomic_load_explicit(&counters->bytesSent, memory_order_relaxed);
+        packetsReceived += atomic_load_explicit(&counters->messagesReceived, memory_order_relaxed);
+        measured++;
+        CloseClient(&bots[i].client);
+    }
+    double perClient = measured ? 1.0 / (measured * elapsed) : 0.0;
+
+    FILE *file = fopen(options.output, "w");
+    if (!file) {
+        printf("Error: Could not write %s\n", options.output);
+        return 1;
+    }
+    fprintf(file, "{\n");
+    fprintf(file, "  \"bots\": %d,\n  \"connected\": %d,\n  \"connect_failures\": %d,\n  \"dropped\": %d,\n",
+            options.botCount, measured, connectFailures, dropped);
+    fprintf(file, "  \"duration_s\": %.3f,\n  \"send_rate\": %d,\n  \"fire_rate\": %.3f,\n", elapsed, options.sendRate, options.fireRate);
+    WriteSamplesJson(file, "server_tick_us", &tickSamples);
+    WriteSamplesJson(file, "update_latency_us", &latencySamples);
+    fprintf(file, "  \"server_overruns\": %u,\n", lastOverruns - firstOverruns);
+    fprintf(file, "  \"rx_bytes_per_client_per_s\": %.1f,\n  \"tx_bytes_per_client_per_s\": %.1f,\n  \"rx_packets_per_client_per_s\": %.1f\n",
+            bytesReceived * perClient, bytesSent * perClient, packetsReceived * perClient);
+    fprintf(file, "}\n");
+    fclose(file);
+
+    printf("tick p50/p99/max %u/%u/%u us, latency p50/p99 %u/%u us, rx %.0f B/s per client, dropped %d\n",
+           Percentile(&tickSamples, 50), Percentile(&tickSamples, 99), tickSamples.count ? tickSamples.values[tickSamples.count - 1] : 0,
+           Percentile(&latencySamples, 50), Percentile(&latencySamples, 99), bytesReceived * perClient, dropped);
+
+    free(tickSamples.values);
+    free(latencySamples.values);
+    free(bots);
+    return 0;
+}
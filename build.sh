@@ -1 +1,6 @@
-gcc main.c -Os $(pkg-config --libs --cflags raylib) -lpthread
\ No newline at end of file
+gcc bake.c mesh.c -Os -o floatyboaty-bake && ./floatyboaty-bake boat.obj boat.mesh
+gcc main.c sprinkles.c ocean.c waves.c quality.c cull.c sim.c collision.c protocol.c client.c server.c interest.c workers.c telemetry.c assets.c mesh.c profiler.c record.c -Os $(pkg-config --libs --cflags raylib) -lpthread -lm
+gcc server_main.c server.c interest.c workers.c telemetry.c sim.c collision.c protocol.c profiler.c record.c -Os -lpthread -lm -o floatyboaty-server
+gcc bots.c client.c telemetry.c protocol.c sim.c collision.c profiler.c record.c -Os -lpthread -lm -o floatyboaty-bots
+gcc replay.c client.c telemetry.c protocol.c sim.c collision.c profiler.c record.c -Os -lpthread -lm -o floatyboaty-replay
+gcc bench.c sim.c collision.c protocol.c profiler.c record.c -Os -lpthread -lm -o floatyboaty-bench && ./floatyboaty-bench --quick
@@ -0,0 +1,472 @@
+#include "client.h"
+#include "profiler.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+static int64_t NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int64_t NowMs(void) {
+    return NowNs() / 1000000;
+}
+
+static void SendBare(NetClient *client, PacketType type) {
+    uint8_t buffer[PACKET_HEADER_SIZE];
+    ByteWriter writer;
+    BeginPacket(&writer, buffer, sizeof(buffer), type, 0);
+    int size = EndPacket(&writer);
+    sendto(client->socket, buffer, size, 0, (struct sockaddr *)&client->server, sizeof(client->server));
+}
+
+bool ConnectClient(NetClient *client, const char *ip, int port) {
+    memset(client, 0, sizeof(*client));
+    client->server = (struct sockaddr_in){.sin_family = AF_INET, .sin_port = htons(port)};
+    for (int i = 0; i < NET_SNAPSHOT_HISTORY; i++) InitNetSnapshot(&client->views[i]);
+    InitTripleBuffer(&client->input.buffer);
+    atomic_init(&client->running, false);
+    atomic_init(&client->closed, false);
+
+    if ((client->socket = socket(AF_INET, SOCK_DGRAM, 0)) < 0 || inet_pton(AF_INET, ip, &client->server.sin_addr) <= 0) {
+        printf("Error: Connection to server failed.\n");
+        CloseClient(client);
+        return false;
+    }
+
+    int64_t deadline = NowMs() + CLIENT_CONNECT_TIMEOUT_MS;
+    while (NowMs() < deadline) {
+        SendBare(client, PACKET_HELLO);
+
+        struct pollfd pfd = {.fd = client->socket, .events = POLLIN};
+        if (poll(&pfd, 1, CLIENT_HELLO_RESEND_MS) <= 0) continue;
+
+        uint8_t buffer[PACKET_MAX_SIZE];
+        ssize_t size = recv(client->socket, buffer, sizeof(buffer), 0);
+        if (size <= 0) continue;
+
+        ByteReader reader;
+        PacketHeader header;
+        InitByteReader(&reader, buffer, (int)size);
+        if (!ReadPacketHeader(&reader, &header) || header.type != PACKET_WELCOME) continue;
+
+        client->playerId = ReadU16(&reader);
+        client->tickRate = ReadU16(&reader);
+        client->maxPlayers = ReadU16(&reader);
+        if (reader.error || client->maxPlayers <= 0) continue;
+
+        fcntl(client->socket, F_SETFL, fcntl(client->socket, F_GETFL, 0) | O_NONBLOCK);
+        InitLinkTelemetry(&client->link, NowMs());
+        InitTripleBuffer(&client->stats.buffer);
+        return true;
+    }
+
+    printf("Error: Server did not answer.\n");
+    CloseClient(client);
+    return false;
+}
+
+void CloseClient(NetClient *client) {
+    StopClientThread(client);
+    if (client->socket > 0) {
+        SendBare(client, PACKET_BYE);
+        close(client->socket);
+    }
+    client->socket = 0;
+    for (int i = 0; i < NET_SNAPSHOT_HISTORY; i++) FreeNetSnapshot(&client->views[i]);
+    for (int i = 0; i < CLIENT_RING_SIZE; i++) FreeNetSnapshot(&client->ring.frames[i].snapshot);
+}
+
+// Queues a copy of a new view for the renderer; drops it if the renderer fell a whole ring behind
+static void PushFrame(NetClient *client, const NetSnapshot *view) {
+    SnapshotRing *ring = &client->ring;
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&ring->tail, memory_order_acquire) >= CLIENT_RING_SIZE) return;
+
+    ClientFrame *frame = &ring->frames[head % CLIENT_RING_SIZE];
+    frame->receivedNs = NowNs();
+    frame->tickUs = client->serverTickUs;
+    frame->overruns = client->serverOverruns;
+    CopyNetSnapshot(&frame->snapshot, view);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+static void HandleSnapshot(NetClient *client, const PacketHeader *header, ByteReader *reader) {
+    uint32_t baselineTick = ReadU32(reader);
+    uint32_t tickUs = ReadU32(reader);
+    uint32_t overruns = ReadU32(reader);
+    const NetSnapshot *baseline = NULL;
+    if (baselineTick != 0) {
+        baseline = &client->views[baselineTick % NET_SNAPSHOT_HISTORY];
+        // Baseline already overwritten by a newer view; the server will resend against a later ack
+        if (baseline->tick != baselineTick) return;
+    }
+
+    NetSnapshot *view = &client->views[header->tick % NET_SNAPSHOT_HISTORY];
+    if (view == baseline) return;
+
+    if (!ReadSnapshotDelta(reader, baseline, view)) {
+        view->tick = 0;
+        return;
+    }
+    view->tick = header->tick;
+
+    if (!client->hasView || (int32_t)(header->tick - client->latestTick) > 0) {
+        client->latestTick = header->tick;
+        client->hasView = true;
+        client->serverTickUs = tickUs;
+        client->serverOverruns = overruns;
+        if (atomic_load_explicit(&client->running, memory_order_relaxed)) PushFrame(client, view);
+    }
+}
+
+// Sends a finished packet to the server and counts it, or counts it dropped
+static void SendPacket(NetClient *client, const uint8_t *buffer, int size) {
+    if (size > 0 && sendto(client->socket, buffer, size, 0, (struct sockaddr *)&client->server, sizeof(client->server)) > 0) {
+        CountSent(&client->link.counters, size);
+        PROFILE_COUNT(COUNTER_BYTES_SENT, size);
+    } else {
+        CountDropped(&client->link.counters);
+    }
+}
+
+static void SendPing(NetClient *client, PacketType type, uint32_t sequence, uint32_t timeUs) {
+    uint8_t buffer[PACKET_HEADER_SIZE + 4];
+    SendPacket(client, buffer, BuildPingPacket(buffer, sizeof(buffer), type, sequence, timeUs));
+}
+
+void PollClient(NetClient *client) {
+    uint8_t buffer[PACKET_MAX_SIZE];
+    ssize_t size;
+
+    while ((size = recv(client->socket, buffer, sizeof(buffer), 0)) > 0) {
+        CountReceived(&client->link.counters, (int)size);
+        PROFILE_COUNT(COUNTER_BYTES_RECEIVED, size);
+
+        ByteReader reader;
+        PacketHeader header;
+        InitByteReader(&reader, buffer, (int)size);
+        if (!ReadPacketHeader(&reader, &header)) continue;
+
+        if (header.type == PACKET_SNAPSHOT) {
+            HandleSnapshot(client, &header, &reader);
+        } else if (header.type == PACKET_BYE) {
+            atomic_store(&client->closed, true);
+        } else if (header.type == PACKET_PING || header.type == PACKET_PONG) {
+            uint32_t timeUs = ReadU32(&reader);
+            if (reader.error) continue;
+            if (header.type == PACKET_PING) SendPing(client, PACKET_PONG, header.tick, timeUs);
+            else ReceivePong(&client->link, header.tick, GetTelemetryClockUs() - timeUs);
+        }
+    }
+}
+
+void SendClientInput(NetClient *client, const PlayerInput *input) {
+    uint8_t buffer[PACKET_MAX_SIZE];
+    ByteWriter writer;
+    BeginPacket(&writer, buffer, sizeof(buffer), PACKET_INPUT, ++client->inputSequence);
+    WriteInput(&writer, input, client->hasView ? client->latestTick : 0);
+    SendPacket(client, buffer, EndPacket(&writer));
+}
+
+// Pings the server when one is due; each closed window goes to the renderer and the log
+static void UpdateClientTelemetry(NetClient *client, int64_t now) {
+    uint32_t sequence;
+    if (NextPing(&client->link, now, &sequence)) SendPing(client, PACKET_PING, sequence, GetTelemetryClockUs());
+
+    StatsMailbox *mailbox = &client->stats;
+    LinkStats *stats = &mailbox->slots[mailbox->buffer.back];
+    if (!CloseLinkWindow(&client->link, now, stats)) return;
+    stats->sendQueueBytes = GetSendQueueBytes(client->socket);
+    stats->tickUs = client->serverTickUs;
+    stats->overruns = client->serverOverruns;
+    PublishTripleBuffer(&mailbox->buffer);
+
+    if (client->telemetry) {
+        char ip[INET_ADDRSTRLEN], name[INET_ADDRSTRLEN + 8];
+        inet_ntop(AF_INET, &client->server.sin_addr, ip, sizeof(ip));
+        snprintf(name, sizeof(name), "%s:%d", ip, ntohs(client->server.sin_port));
+        WriteLinkStats(client->telemetry, -1, client->playerId, name, stats);
+        FlushTelemetryLog(client->telemetry);
+    }
+}
+
+const NetSnapshot *GetLatestView(const NetClient *client) {
+    if (!client->hasView) return NULL;
+    return &client->views[client->latestTick % NET_SNAPSHOT_HISTORY];
+}
+
+// Adds a cannonball to a client-side world, already moved to where it is drawn
+static void ShowCannonball(ProjectilePool *pool, int owner, Vec3 origin, Vec3 direction, uint32_t launchTick, Vec3 position) {
+    int slot = pool->count;
+    if (SpawnProjectile(pool, owner, origin, direction, launchTick) >= 0) pool->position[slot] = position;
+}
+
+static void ShowNetCannonball(ProjectilePool *pool, const NetEntity *entity, double tick, int tickRate) {
+    Vec3 origin = {DequantizePosition(entity->position[0]), DequantizePosition(entity->position[1]), DequantizePosition(entity->position[2])};
+    Vec3 direction = {DequantizeDirection(entity->direction[0]), DequantizeDirection(entity->direction[1]), DequantizeDirection(entity->direction[2])};
+    ShowCannonball(pool, entity->value, origin, direction, entity->startTick, GetNetCannonballPosition(entity, tick, tickRate));
+}
+
+void NetViewToWorld(const NetSnapshot *view, int tickRate, WorldSnapshot *world) {
+    memset(world->players, 0, world->playerCount * sizeof(Player));
+    ClearProjectilePool(&world->projectiles);
+    world->tick = view->tick;
+
+    for (int i = 0; i < view->count; i++) {
+        const NetEntity *entity = &view->entities[i];
+        if (entity->kind == ENTITY_BOAT && entity->id < world->playerCount) {
+            Player *player = &world->players[entity->id];
+            player->active = true;
+            player->health = entity->value;
+            player->position = (BoatPosition){DequantizePosition(entity->position[0]),
+                                              DequantizePosition(entity->position[1]),
+                                              DequantizePosition(entity->position[2])};
+        } else if (entity->kind == ENTITY_CANNONBALL && entity->value < world->playerCount) {
+            ShowNetCannonball(&world->projectiles, entity, view->tick, tickRate);
+        }
+    }
+}
+
+static void *ClientThread(void *args) {
+    NetClient *client = (NetClient *)args;
+    int64_t period = 1000000000 / client->tickRate;
+    int64_t nextSend = NowNs();
+    PlayerInput input = {0};
+
+    while (atomic_load(&client->running)) {
+        int waitMs = (int)((nextSend - NowNs() + 999999) / 1000000);
+        struct pollfd pfd = {.fd = client->socket, .events = POLLIN};
+        poll(&pfd, 1, waitMs > 0 ? waitMs : 0);
+        PollClient(client);
+
+        int64_t now = NowNs();
+        UpdateClientTelemetry(client, now / 1000000);
+        if (now >= nextSend) {
+            InputMailbox *mailbox = &client->input;
+            if (AcquireTripleBuffer(&mailbox->buffer)) input = mailbox->slots[mailbox->buffer.front];
+            if (input.connected) SendClientInput(client, &input);
+            nextSend += period;
+            if (nextSend < now) nextSend = now + period;
+        }
+    }
+    return NULL;
+}
+
+void StartClientThread(NetClient *client) {
+    atomic_store(&client->running, true);
+    pthread_create(&client->thread, NULL, ClientThread, client);
+}
+
+void StopClientThread(NetClient *client) {
+    if (!atomic_exchange(&client->running, false)) return;
+    pthread_join(client->thread, NULL);
+}
+
+void SubmitClientInput(NetClient *client, const PlayerInput *input) {
+    InputMailbox *mailbox = &client->input;
+    mailbox->slots[mailbox->buffer.back] = *input;
+    PublishTripleBuffer(&mailbox->buffer);
+}
+
+const LinkStats *GetClientStats(NetClient *client) {
+    StatsMailbox *mailbox = &client->stats;
+    AcquireTripleBuffer(&mailbox->buffer);
+    return &mailbox->slots[mailbox->buffer.front];
+}
+
+void InitInterpolator(SnapshotInterpolator *interp, int tickRate, int delayMs) {
+    memset(interp, 0, sizeof(*interp));
+    interp->tickRate = tickRate;
+    interp->delayMs = delayMs;
+    interp->lastFrameNs = NowNs();
+    for (int i = 0; i < CLIENT_INTERP_FRAMES; i++) InitNetSnapshot(&interp->frames[i].snapshot);
+}
+
+void FreeInterpolator(SnapshotInterpolator *interp) {
+    for (int i = 0; i < CLIENT_INTERP_FRAMES; i++) FreeNetSnapshot(&interp->frames[i].snapshot);
+    interp->count = 0;
+}
+
+void ReceiveFrames(SnapshotInterpolator *interp, NetClient *client) {
+    SnapshotRing *ring = &client->ring;
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    // Stamped on arrival here rather than from the frames, which may have queued while the renderer stalled
+    if (tail != head) interp->lastFrameNs = NowNs();
+
+    for (; tail != head; tail++) {
+        const ClientFrame *src = &ring->frames[tail % CLIENT_RING_SIZE];
+
+        // Full: recycle the oldest frame's storage as the newest
+        if (interp->count == CLIENT_INTERP_FRAMES) {
+            ClientFrame oldest = interp->frames[0];
+            memmove(&interp->frames[0], &interp->frames[1], (CLIENT_INTERP_FRAMES - 1) * sizeof(ClientFrame));
+            interp->frames[CLIENT_INTERP_FRAMES - 1] = oldest;
+            interp->count--;
+        }
+        ClientFrame *dst = &interp->frames[interp->count++];
+        dst->receivedNs = src->receivedNs;
+        dst->tickUs = src->tickUs;
+        dst->overruns = src->overruns;
+        CopyNetSnapshot(&dst->snapshot, &src->snapshot);
+    }
+    atomic_store_explicit(&ring->tail, tail, memory_order_release);
+}
+
+bool IsServerLost(const SnapshotInterpolator *interp, const NetClient *client) {
+    return atomic_load(&client->closed) || (NowNs() - interp->lastFrameNs) / 1000000 > CLIENT_SILENCE_TIMEOUT_MS;
+}
+
+void PredictShot(SnapshotInterpolator *interp, Vec3 origin, Vec3 direction) {
+    if (interp->shotCount == CLIENT_MAX_PREDICTED_SHOTS) return;
+    interp->shots[interp->shotCount++] = (PredictedShot){origin, direction, interp->clientTick, -1, 0};
+}
+
+// Steers the playback clock toward the server's tick as seen from the newest
+// snapshot, gently so jittery arrivals don't make remote boats stutter
+static void AdvanceClock(SnapshotInterpolator *interp, float dt) {
+    const ClientFrame *newest = &interp->frames[interp->count - 1];
+    double target = newest->snapshot.tick + (NowNs() - newest->receivedNs) / 1e9 * interp->tickRate;
+
+    interp->clientTick += dt * interp->tickRate;
+    double error = target - interp->clientTick;
+    if (!interp->synced || fabs(error) > interp->tickRate / 2.0) {
+        interp->clientTick = target;
+        interp->synced = true;
+    } else {
+        interp->clientTick += error * 0.05;
+    }
+    interp->renderTick = interp->clientTick - interp->delayMs / 1000.0 * interp->tickRate;
+}
+
+static const NetEntity *FindEntity(const NetSnapshot *snapshot, uint8_t kind, uint16_t id) {
+    int lo = 0, hi = snapshot->count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        const NetEntity *entity = &snapshot->entities[mid];
+        int order = (entity->kind != kind) ? entity->kind - kind : entity->id - id;
+        if (order == 0) return entity;
+        if (order < 0) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return NULL;
+}
+
+static bool IsShotClaimed(const SnapshotInterpolator *interp, int id) {
+    for (int i = 0; i < interp->shotCount; i++) {
+        if (interp->shots[i].serverId == id) return true;
+    }
+    return false;
+}
+
+// Pairs predicted shots with the server's copies as they appear and drops the
+// ones the server finished or never confirmed
+static void ReconcileShots(SnapshotInterpolator *interp, const NetSnapshot *newest, int localPlayer) {
+    for (int i = 0; i < interp->shotCount; i++) {
+        PredictedShot *shot = &interp->shots[i];
+        bool keep = true;
+
+        if (shot->serverId < 0) {
+            // Shots are kept oldest first, so each takes the earliest unclaimed copy fired after it
+            const NetEntity *match = NULL;
+            for (int j = 0; j < newest->count; j++) {
+                const NetEntity *entity = &newest->entities[j];
+                if (entity->kind != ENTITY_CANNONBALL || entity->value != localPlayer) continue;
+                if (entity->startTick + 2.0 < shot->launchTick || IsShotClaimed(interp, entity->id)) continue;
+                if (!match || entity->startTick < match->startTick) match = entity;
+            }
+            if (match) {
+                shot->serverId = match->id;
+                shot->serverStartTick = match->startTick;
+            }
+            keep = match || interp->clientTick - shot->launchTick < interp->tickRate;
+        } else {
+            const NetEntity *entity = FindEntity(newest, ENTITY_CANNONBALL, (uint16_t)shot->serverId);
+            keep = entity && entity->startTick == shot->serverStartTick;
+        }
+
+        if (!keep) {
+            memmove(&interp->shots[i], &interp->shots[i + 1], (interp->shotCount - i - 1) * sizeof(PredictedShot));
+            interp->shotCount--;
+            i--;
+        }
+    }
+}
+
+static Vec3 LerpPosition(const NetEntity *a, const NetEntity *b, float t) {
+    Vec3 result;
+    float *out = &result.x;
+    for (int k = 0; k < 3; k++) {
+        float from = DequantizePosition(a->position[k]);
+        out[k] = from + (DequantizePosition(b->position[k]) - from) * t;
+    }
+    return result;
+}
+
+void InterpolateWorld(SnapshotInterpolator *interp, float dt, int localPlayer, WorldSnapshot *world) {
+    memset(world->players, 0, world->playerCount * sizeof(Player));
+    ClearProjectilePool(&world->projectiles);
+    if (interp->count == 0) return;
+
+    AdvanceClock(interp, dt);
+    const NetSnapshot *newest = &interp->frames[interp->count - 1].snapshot;
+    ReconcileShots(interp, newest, localPlayer);
+
+    // Frames a and b bracket renderTick; before the buffer fills up, or if it runs dry, hold the nearest one
+    int b = 0;
+    while (b < interp->count && interp->frames[b].snapshot.tick <= interp->renderTick) b++;
+    int a = (b > 0) ? b - 1 : 0;
+    if (b == interp->count) b = a;
+    const NetSnapshot *from = &interp->frames[a].snapshot;
+    const NetSnapshot *to = &interp->frames[b].snapshot;
+    float t = (to->tick != from->tick) ? (float)((interp->renderTick - from->tick) / (double)(to->tick - from->tick)) : 0.0f;
+    if (t < 0.0f) t = 0.0f;
+
+    world->tick = (uint32_t)interp->renderTick;
+    world->tickNs = (uint64_t)interp->frames[interp->count - 1].tickUs * 1000;
+    world->overruns = interp->frames[interp->count - 1].overruns;
+
+    for (int i = 0; i < from->count; i++) {
+        const NetEntity *entity = &from->entities[i];
+        if (entity->kind != ENTITY_BOAT) break;
+        if (entity->id >= world->playerCount) continue;
+
+        const NetEntity *next = FindEntity(to, ENTITY_BOAT, entity->id);
+        Vec3 position = LerpPosition(entity, next ? next : entity, t);
+        Player *player = &world->players[entity->id];
+        player->active = true;
+        player->health = entity->value;
+        player->position = (BoatPosition){position.x, position.y, position.z};
+    }
+
+    // Cannonballs fly straight, so any tick can be evaluated exactly; the local
+    // player's are shown at the present rather than in the delayed past
+    for (int i = 0; i < to->count; i++) {
+        const NetEntity *entity = &to->entities[i];
+        if (entity->kind != ENTITY_CANNONBALL || entity->value >= world->playerCount) continue;
+        int owner = entity->value;
+        if (owner == localPlayer && IsShotClaimed(interp, entity->id)) continue;
+
+        double tick = (owner == localPlayer) ? interp->clientTick : interp->renderTick;
+        if (tick < entity->startTick) continue;
+        ShowNetCannonball(&world->projectiles, entity, tick, interp->tickRate);
+    }
+
+    for (int i = 0; i < interp->shotCount; i++) {
+        const PredictedShot *shot = &interp->shots[i];
+        float distance = (float)((interp->clientTick - shot->launchTick) / interp->tickRate) * CANNONBALL_SPEED;
+        Vec3 position = {shot->origin.x + shot->direction.x * distance,
+                         shot->origin.y + shot->direction.y * distance,
+                         shot->origin.z + shot->direction.z * distance};
+        ShowCannonball(&world->projectiles, localPlayer, shot->origin, shot->direction, (uint32_t)shot->launchTick, position);
+    }
+}
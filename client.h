@@ -0,0 +1,119 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include "protocol.h"
+#include "telemetry.h"
+#include <netinet/in.h>
+
+#define CLIENT_CONNECT_TIMEOUT_MS 3000
+#define CLIENT_HELLO_RESEND_MS 250
+// The game gives up on a server that has sent no snapshot for this long
+#define CLIENT_SILENCE_TIMEOUT_MS 3000
+
+// Decoded snapshots handed from the network thread to the renderer
+#define CLIENT_RING_SIZE 64
+// Snapshots the renderer keeps around to interpolate between
+#define CLIENT_INTERP_FRAMES 16
+// How far behind the newest snapshot remote boats are drawn, room for a few late packets
+#define CLIENT_DEFAULT_INTERP_DELAY_MS 100
+#define CLIENT_MAX_PREDICTED_SHOTS MAX_CANNONBALLS
+
+typedef struct {
+    int64_t receivedNs;        // CLOCK_MONOTONIC arrival time
+    uint32_t tickUs;           // server timing at that tick
+    uint32_t overruns;
+    NetSnapshot snapshot;
+} ClientFrame;
+
+// Lock-free single-producer/single-consumer queue; the network thread fills
+// frames[head], the renderer drains frames[tail]
+typedef struct {
+    _Atomic uint32_t head;
+    _Atomic uint32_t tail;
+    ClientFrame frames[CLIENT_RING_SIZE];
+} SnapshotRing;
+
+// UDP connection to a server and the snapshots decoded from it
+typedef struct {
+    int socket;
+    struct sockaddr_in server;
+    int playerId;
+    int tickRate;
+    int maxPlayers;
+    uint32_t inputSequence;
+    uint32_t latestTick;                           // newest snapshot decoded so far
+    NetSnapshot views[NET_SNAPSHOT_HISTORY];       // decoded snapshots by tick, baselines for later deltas
+    bool hasView;
+    atomic_bool closed;                            // the server said BYE, set by the network thread
+    uint32_t serverTickUs;                         // server step time and overrun count of the latest view
+    uint32_t serverOverruns;
+    LinkTelemetry link;                            // traffic and round trips to the server
+    TelemetryLog *telemetry;                       // set before StartClientThread to log every window
+
+    // With the network thread running, it owns everything above
+    pthread_t thread;
+    atomic_bool running;
+    InputMailbox input;                            // latest input from the renderer
+    SnapshotRing ring;                             // every newer snapshot, for the renderer
+    StatsMailbox stats;                            // latest telemetry window, for the renderer
+} NetClient;
+
+// A shot drawn right away, before the server confirms it
+typedef struct {
+    Vec3 origin;
+    Vec3 direction;
+    double launchTick;         // estimate of the server tick when fired
+    int serverId;              // matching server cannonball, -1 until it shows up
+    uint32_t serverStartTick;
+} PredictedShot;
+
+// Renderer side: buffers snapshots and plays them back a fixed delay behind the server
+typedef struct {
+    int tickRate;
+    int delayMs;
+    double clientTick;         // smoothed estimate of the server's current tick
+    double renderTick;         // clientTick minus the delay, where remote boats are drawn
+    bool synced;
+    int64_t lastFrameNs;       // when ReceiveFrames last got a snapshot
+    ClientFrame frames[CLIENT_INTERP_FRAMES];      // oldest first
+    int count;
+    PredictedShot shots[CLIENT_MAX_PREDICTED_SHOTS];
+    int shotCount;
+} SnapshotInterpolator;
+
+// Sends HELLO until the server answers with WELCOME or the timeout runs out
+bool ConnectClient(NetClient *client, const char *ip, int port);
+void CloseClient(NetClient *client);
+
+// Drains every datagram waiting on the socket without blocking; answers the server's pings
+void PollClient(NetClient *client);
+void SendClientInput(NetClient *client, const PlayerInput *input);
+
+// Moves receiving and sending onto a thread so the caller never waits on the socket
+void StartClientThread(NetClient *client);
+void StopClientThread(NetClient *client);
+// Never blocks; the network thread sends the latest input once per server tick
+void SubmitClientInput(NetClient *client, const PlayerInput *input);
+// Latest telemetry window the network thread closed, zeroed until the first one;
+// valid until the next call
+const LinkStats *GetClientStats(NetClient *client);
+
+// Newest decoded snapshot, or NULL before the first one arrives
+const NetSnapshot *GetLatestView(const NetClient *client);
+// Expands a decoded snapshot back into the sim's world layout for drawing;
+// `world` must hold the server's maxPlayers slots
+void NetViewToWorld(const NetSnapshot *view, int tickRate, WorldSnapshot *world);
+
+void InitInterpolator(SnapshotInterpolator *interp, int tickRate, int delayMs);
+void FreeInterpolator(SnapshotInterpolator *interp);
+// Takes every snapshot the network thread queued since the last call
+void ReceiveFrames(SnapshotInterpolator *interp, NetClient *client);
+// True once the server said BYE or has sent no snapshot for CLIENT_SILENCE_TIMEOUT_MS
+bool IsServerLost(const SnapshotInterpolator *interp, const NetClient *client);
+// Draws the local player's shot immediately instead of a round trip later
+void PredictShot(SnapshotInterpolator *interp, Vec3 origin, Vec3 direction);
+// Advances the playback clock by dt seconds and fills `world` with boats interpolated
+// at renderTick; the local player's cannonballs are shown at clientTick
+void InterpolateWorld(SnapshotInterpolator *interp, float dt, int localPlayer, WorldSnapshot *world);
+
+#endif
@@ -0,0 +1,174 @@
+#include "collision.h"
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+void InitCollisionGrid(CollisionGrid *grid, float width, float length, float cellSize) {
+    memset(grid, 0, sizeof(*grid));
+    grid->cellSize = cellSize;
+    grid->cellsX = (int)(width / cellSize) + 1;
+    grid->cellsZ = (int)(length / cellSize) + 1;
+    grid->originX = -width / 2;
+    grid->originZ = -length / 2;
+    grid->cellBegin = calloc(grid->cellsX * grid->cellsZ, sizeof(int));
+    grid->cellEnd = calloc(grid->cellsX * grid->cellsZ, sizeof(int));
+}
+
+static void FreeProjectileArrays(CollisionGrid *grid) {
+    free(grid->stageX);
+    free(grid->stageY);
+    free(grid->stageZ);
+    free(grid->stageOwner);
+    free(grid->stageRef);
+    free(grid->stageCell);
+    free(grid->order);
+    free(grid->scratch);
+    free(grid->cell);
+    free(grid->x);
+    free(grid->y);
+    free(grid->z);
+    free(grid->owner);
+    free(grid->ref);
+    free(grid->spent);
+}
+
+void FreeCollisionGrid(CollisionGrid *grid) {
+    FreeProjectileArrays(grid);
+    free(grid->cellBegin);
+    free(grid->cellEnd);
+    memset(grid, 0, sizeof(*grid));
+}
+
+void ResetCollisionGrid(CollisionGrid *grid) {
+    grid->count = 0;
+}
+
+static int ClampCell(int cell, int cells) {
+    if (cell < 0) return 0;
+    if (cell >= cells) return cells - 1;
+    return cell;
+}
+
+void AddProjectile(CollisionGrid *grid, float x, float y, float z, int owner, int ref) {
+    if (grid->count == grid->capacity) {
+        int capacity = grid->capacity ? grid->capacity * 2 : 256;
+        grid->stageX = realloc(grid->stageX, capacity * sizeof(float));
+        grid->stageY = realloc(grid->stageY, capacity * sizeof(float));
+        grid->stageZ = realloc(grid->stageZ, capacity * sizeof(float));
+        grid->stageOwner = realloc(grid->stageOwner, capacity * sizeof(int));
+        grid->stageRef = realloc(grid->stageRef, capacity * sizeof(int));
+        grid->stageCell = realloc(grid->stageCell, capacity * sizeof(int));
+        grid->order = realloc(grid->order, capacity * sizeof(int));
+        grid->scratch = realloc(grid->scratch, capacity * sizeof(int));
+        grid->cell = realloc(grid->cell, capacity * sizeof(int));
+        grid->x = realloc(grid->x, capacity * sizeof(float));
+        grid->y = realloc(grid->y, capacity * sizeof(float));
+        grid->z = realloc(grid->z, capacity * sizeof(float));
+        grid->owner = realloc(grid->owner, capacity * sizeof(int));
+        grid->ref = realloc(grid->ref, capacity * sizeof(int));
+        grid->spent = realloc(grid->spent, capacity);
+        grid->capacity = capacity;
+    }
+
+    // Anything off the plane lands in the border cells
+    int cx = ClampCell((int)((x - grid->originX) / grid->cellSize), grid->cellsX);
+    int cz = ClampCell((int)((z - grid->originZ) / grid->cellSize), grid->cellsZ);
+
+    int i = grid->count++;
+    grid->stageX[i] = x;
+    grid->stageY[i] = y;
+    grid->stageZ[i] = z;
+    grid->stageOwner[i] = owner;
+    grid->stageRef[i] = ref;
+    grid->stageCell[i] = cz * grid->cellsX + cx;
+}
+
+void BuildCollisionGrid(CollisionGrid *grid) {
+    // Empty the cells of the last build; the rest are empty already
+    for (int i = 0; i < grid->builtCount; i++) grid->cellBegin[grid->cell[i]] = grid->cellEnd[grid->cell[i]] = 0;
+
+    // LSD radix sort of the staged indices, a byte of the cell per pass.
+    // Stable, so hits stay deterministic.
+    int *order = grid->order, *scratch = grid->scratch;
+    for (int i = 0; i < grid->count; i++) order[i] = i;
+    int maxCell = grid->cellsX * grid->cellsZ - 1;
+    for (int shift = 0; maxCell >> shift; shift += 8) {
+        int start[257] = {0};
+        for (int i = 0; i < grid->count; i++) start[((grid->stageCell[order[i]] >> shift) & 255) + 1]++;
+        for (int b = 0; b < 256; b++) start[b + 1] += start[b];
+        for (int i = 0; i < grid->count; i++) scratch[start[(grid->stageCell[order[i]] >> shift) & 255]++] = order[i];
+        int *sorted = scratch;
+        scratch = order;
+        order = sorted;
+    }
+    grid->order = order;
+    grid->scratch = scratch;
+
+    for (int dst = 0; dst < grid->count; dst++) {
+        int i = order[dst];
+        grid->cell[dst] = grid->stageCell[i];
+        grid->x[dst] = grid->stageX[i];
+        grid->y[dst] = grid->stageY[i];
+        grid->z[dst] = grid->stageZ[i];
+        grid->owner[dst] = grid->stageOwner[i];
+        grid->ref[dst] = grid->stageRef[i];
+        if (dst == 0 || grid->cell[dst - 1] != grid->cell[dst]) grid->cellBegin[grid->cell[dst]] = dst;
+        grid->cellEnd[grid->cell[dst]] = dst + 1;
+    }
+    grid->builtCount = grid->count;
+    memset(grid->spent, 0, grid->count);
+}
+
+// Claims projectile i if it may hit; returns false once hits is full
+static bool TryHit(CollisionGrid *grid, int i, int ignoreOwner, int *hits, int *found, int maxHits) {
+    if (grid->spent[i] || grid->owner[i] == ignoreOwner) return true;
+    grid->spent[i] = 1;
+    hits[(*found)++] = grid->ref[i];
+    return *found < maxHits;
+}
+
+// Narrow phase over one cell's contiguous run, four squared distances at a time
+static bool CollideRun(CollisionGrid *grid, int begin, int end, float x, float y, float z, float radiusSq,
+                       int ignoreOwner, int *hits, int *found, int maxHits) {
+    int i = begin;
+#if defined(__SSE__)
+    __m128 px = _mm_set1_ps(x), py = _mm_set1_ps(y), pz = _mm_set1_ps(z), r2 = _mm_set1_ps(radiusSq);
+    for (; i + 4 <= end; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(grid->x + i), px);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(grid->y + i), py);
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(grid->z + i), pz);
+        __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        int mask = _mm_movemask_ps(_mm_cmplt_ps(d2, r2));
+        for (; mask; mask &= mask - 1) {
+            if (!TryHit(grid, i + __builtin_ctz(mask), ignoreOwner, hits, found, maxHits)) return false;
+        }
+    }
+#endif
+    for (; i < end; i++) {
+        float dx = grid->x[i] - x, dy = grid->y[i] - y, dz = grid->z[i] - z;
+        if (dx * dx + dy * dy + dz * dz < radiusSq && !TryHit(grid, i, ignoreOwner, hits, found, maxHits)) return false;
+    }
+    return true;
+}
+
+int CollideSphere(CollisionGrid *grid, float x, float y, float z, float radius, int ignoreOwner, int *hits, int maxHits) {
+    if (maxHits <= 0 || grid->count == 0) return 0;
+
+    // Border cells also hold everything beyond the edge, so clamping keeps those reachable
+    int minX = ClampCell((int)((x - radius - grid->originX) / grid->cellSize), grid->cellsX);
+    int maxX = ClampCell((int)((x + radius - grid->originX) / grid->cellSize), grid->cellsX);
+    int minZ = ClampCell((int)((z - radius - grid->originZ) / grid->cellSize), grid->cellsZ);
+    int maxZ = ClampCell((int)((z + radius - grid->originZ) / grid->cellSize), grid->cellsZ);
+
+    int found = 0;
+    for (int cz = minZ; cz <= maxZ; cz++) {
+        for (int c = cz * grid->cellsX + minX; c <= cz * grid->cellsX + maxX; c++) {
+            if (!CollideRun(grid, grid->cellBegin[c], grid->cellEnd[c], x, y, z, radius * radius, ignoreOwner, hits, &found, maxHits)) {
+                return found;
+            }
+        }
+    }
+    return found;
+}
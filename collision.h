@@ -0,0 +1,47 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Hash cells are twice the hit radius so a hit query touches at most 2x2 cells
+#define COLLISION_CELL_SIZE 2.0f
+
+// Uniform spatial hash of projectiles over the water plane, rebuilt every tick.
+// Projectiles are staged unsorted, then radix-sorted by cell into
+// structure-of-arrays storage so each cell is a contiguous run of floats.
+// Only occupied cells are written and cleared, so a build costs the same on any size of water.
+typedef struct {
+    float originX, originZ;    // corner of cell (0, 0)
+    float cellSize;
+    int cellsX, cellsZ;
+    int *cellBegin, *cellEnd;  // cellsX * cellsZ runs in the sorted arrays, empty ones 0, 0
+
+    int count;
+    int builtCount;            // count of the last build, whose cells are still set
+    int capacity;
+    // Staged in insertion order
+    float *stageX, *stageY, *stageZ;
+    int *stageOwner, *stageRef, *stageCell;
+    int *order, *scratch;      // staged indices while sorting
+    // Sorted by cell
+    int *cell;                 // ascending
+    float *x, *y, *z;
+    int *owner;                // projectiles never hit their owner
+    int *ref;                  // caller's handle for the projectile
+    uint8_t *spent;            // already hit something this tick
+} CollisionGrid;
+
+void InitCollisionGrid(CollisionGrid *grid, float width, float length, float cellSize);
+void FreeCollisionGrid(CollisionGrid *grid);
+
+void ResetCollisionGrid(CollisionGrid *grid);
+void AddProjectile(CollisionGrid *grid, float x, float y, float z, int owner, int ref);
+// Sorts the staged projectiles into their cells; call once after the last AddProjectile
+void BuildCollisionGrid(CollisionGrid *grid);
+
+// Finds up to maxHits unspent projectiles of other owners strictly inside the sphere,
+// marks them spent and writes their refs to hits. Returns how many were found.
+int CollideSphere(CollisionGrid *grid, float x, float y, float z, float radius, int ignoreOwner, int *hits, int maxHits);
+
+#endif
@@ -0,0 +1,116 @@
+#include "cull.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include <math.h>
+#include <stdlib.h>
+
+static Vector4 NormalizePlane(float a, float b, float c, float d) {
+    float length = sqrtf(a * a + b * b + c * c);
+    return (Vector4){a / length, b / length, c / length, d / length};
+}
+
+Frustum GetCameraFrustum(Camera3D camera, float aspect, float drawDistance) {
+    Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+    Matrix projection = MatrixPerspective(camera.fovy * DEG2RAD, aspect, RL_CULL_DISTANCE_NEAR, drawDistance);
+    Matrix m = MatrixMultiply(view, projection);
+
+    // Gribb/Hartmann plane extraction from the rows of the clip matrix
+    Frustum frustum;
+    frustum.planes[0] = NormalizePlane(m.m3 + m.m0, m.m7 + m.m4, m.m11 + m.m8, m.m15 + m.m12);
+    frustum.planes[1] = NormalizePlane(m.m3 - m.m0, m.m7 - m.m4, m.m11 - m.m8, m.m15 - m.m12);
+    frustum.planes[2] = NormalizePlane(m.m3 + m.m1, m.m7 + m.m5, m.m11 + m.m9, m.m15 + m.m13);
+    frustum.planes[3] = NormalizePlane(m.m3 - m.m1, m.m7 - m.m5, m.m11 - m.m9, m.m15 - m.m13);
+    frustum.planes[4] = NormalizePlane(m.m3 + m.m2, m.m7 + m.m6, m.m11 + m.m10, m.m15 + m.m14);
+    frustum.planes[5] = NormalizePlane(m.m3 - m.m2, m.m7 - m.m6, m.m11 - m.m10, m.m15 - m.m14);
+    return frustum;
+}
+
+bool FrustumContainsBox(const Frustum *frustum, BoundingBox box) {
+    for (int i = 0; i < 6; i++) {
+        Vector4 p = frustum->planes[i];
+        // Corner furthest along the plane normal
+        float x = (p.x >= 0) ? box.max.x : box.min.x;
+        float y = (p.y >= 0) ? box.max.y : box.min.y;
+        float z = (p.z >= 0) ? box.max.z : box.min.z;
+        if (p.x * x + p.y * y + p.z * z + p.w < 0) return false;
+    }
+    return true;
+}
+
+bool FrustumContainsSphere(const Frustum *frustum, Vector3 center, float radius) {
+    for (int i = 0; i < 6; i++) {
+        Vector4 p = frustum->planes[i];
+        if (p.x * center.x + p.y * center.y + p.z * center.z + p.w < -radius) return false;
+    }
+    return true;
+}
+
+void InitCullGrid(CullGrid *grid, Vector2 areaSize, float cellSize) {
+    grid->origin = (Vector2){-areaSize.x / 2, -areaSize.y / 2};
+    grid->cellSize = cellSize;
+    grid->cellsX = (int)ceilf(areaSize.x / cellSize);
+    grid->cellsZ = (int)ceilf(areaSize.y / cellSize);
+    grid->bounds = MemAlloc(grid->cellsX * grid->cellsZ * sizeof(BoundingBox));
+    grid->visible = MemAlloc(grid->cellsX * grid->cellsZ * sizeof(bool));
+
+    for (int z = 0; z < grid->cellsZ; z++) {
+        for (int x = 0; x < grid->cellsX; x++) {
+            BoundingBox *box = &grid->bounds[z * grid->cellsX + x];
+            box->min = (Vector3){grid->origin.x + x * cellSize - CULL_CELL_PADDING, CULL_CELL_MIN_Y,
+                                 grid->origin.y + z * cellSize - CULL_CELL_PADDING};
+            box->max = (Vector3){grid->origin.x + (x + 1) * cellSize + CULL_CELL_PADDING, CULL_CELL_MAX_Y,
+                                 grid->origin.y + (z + 1) * cellSize + CULL_CELL_PADDING};
+        }
+    }
+}
+
+void FreeCullGrid(CullGrid *grid) {
+    MemFree(grid->bounds);
+    MemFree(grid->visible);
+    grid->bounds = NULL;
+    grid->visible = NULL;
+    grid->cellsX = grid->cellsZ = 0;
+}
+
+int GetCullCell(const CullGrid *grid, float x, float z) {
+    int cx = (int)floorf((x - grid->origin.x) / grid->cellSize);
+    int cz = (int)floorf((z - grid->origin.y) / grid->cellSize);
+    if (cx < 0 || cz < 0 || cx >= grid->cellsX || cz >= grid->cellsZ) return -1;
+    return cz * grid->cellsX + cx;
+}
+
+void GrowCullCell(CullGrid *grid, int cell, BoundingBox box) {
+    BoundingBox *b = &grid->bounds[cell];
+    b->min = Vector3Min(b->min, box.min);
+    b->max = Vector3Max(b->max, box.max);
+}
+
+// Squared distance from a point to the closest point of a box
+static float BoxDistanceSqr(BoundingBox box, Vector3 p) {
+    float dx = fmaxf(fmaxf(box.min.x - p.x, 0.0f), p.x - box.max.x);
+    float dy = fmaxf(fmaxf(box.min.y - p.y, 0.0f), p.y - box.max.y);
+    float dz = fmaxf(fmaxf(box.min.z - p.z, 0.0f), p.z - box.max.z);
+    return dx * dx + dy * dy + dz * dz;
+}
+
+bool IsBoxVisible(const Frustum *frustum, Vector3 eye, float drawDistance, BoundingBox box) {
+    return BoxDistanceSqr(box, eye) <= drawDistance * drawDistance && FrustumContainsBox(frustum, box);
+}
+
+void UpdateCullGrid(CullGrid *grid, const Frustum *frustum, Vector3 eye, float drawDistance, CullStats *stats) {
+    int cellCount = grid->cellsX * grid->cellsZ;
+
+    *stats = (CullStats){ 0 };
+    for (int i = 0; i < cellCount; i++) {
+        grid->visible[i] = IsBoxVisible(frustum, eye, drawDistance, grid->bounds[i]);
+        if (grid->visible[i]) stats->visibleCells++;
+        else stats->culledCells++;
+    }
+}
+
+bool IsSphereVisible(const CullGrid *grid, const Frustum *frustum, Vector3 eye, float drawDistance, Vector3 center, float radius) {
+    int cell = GetCullCell(grid, center.x, center.z);
+    if (cell >= 0 && !grid->visible[cell]) return false;
+    if (Vector3Distance(eye, center) - radius > drawDistance) return false;
+    return FrustumContainsSphere(frustum, center, radius);
+}
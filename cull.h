@@ -0,0 +1,56 @@
+#ifndef CULL_H
+#define CULL_H
+
+#include "raylib.h"
+
+#define CULL_CELL_SIZE 25.0f
+#define CULL_DEFAULT_DRAW_DISTANCE 150.0f
+
+// Starting height range of every cell, enough for the water and a boat on it
+#define CULL_CELL_MIN_Y -1.0f
+#define CULL_CELL_MAX_Y 6.0f
+
+// Objects are bucketed by their center, so cells are padded by the largest object radius
+#define CULL_CELL_PADDING 5.0f
+
+// Six normalized planes (left, right, bottom, top, near, far), inside is positive
+typedef struct {
+    Vector4 planes[6];
+} Frustum;
+
+// Uniform bucket grid over the water plane with per-cell bounds
+typedef struct {
+    Vector2 origin;        // minimum x/z corner of the grid
+    float cellSize;
+    int cellsX, cellsZ;
+    BoundingBox *bounds;   // cellsX * cellsZ, grown to fit whatever is bucketed
+    bool *visible;         // per-cell result of the last UpdateCullGrid
+} CullGrid;
+
+// Per-frame counters so the savings can be inspected
+typedef struct {
+    int visibleCells;
+    int culledCells;
+    int visibleObjects;
+    int culledObjects;
+} CullStats;
+
+Frustum GetCameraFrustum(Camera3D camera, float aspect, float drawDistance);
+bool FrustumContainsBox(const Frustum *frustum, BoundingBox box);
+bool FrustumContainsSphere(const Frustum *frustum, Vector3 center, float radius);
+// Within the draw distance of `eye` and at least partly inside the frustum
+bool IsBoxVisible(const Frustum *frustum, Vector3 eye, float drawDistance, BoundingBox box);
+
+void InitCullGrid(CullGrid *grid, Vector2 areaSize, float cellSize);
+void FreeCullGrid(CullGrid *grid);
+int GetCullCell(const CullGrid *grid, float x, float z);
+void GrowCullCell(CullGrid *grid, int cell, BoundingBox box);
+
+// Marks each cell visible or culled against the frustum and the draw distance,
+// and resets the object counters for the frame
+void UpdateCullGrid(CullGrid *grid, const Frustum *frustum, Vector3 eye, float drawDistance, CullStats *stats);
+
+// Tests one object: its cell must be visible and it must lie within frustum and range
+bool IsSphereVisible(const CullGrid *grid, const Frustum *frustum, Vector3 eye, float drawDistance, Vector3 center, float radius);
+
+#endif
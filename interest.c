@@ -0,0 +1,133 @@
+#include "interest.h"
+#include <stdlib.h>
+#include <string.h>
+
+void InitInterestGrid(InterestGrid *grid, float width, float length, float cellSize, int maxPlayers) {
+    memset(grid, 0, sizeof(*grid));
+    grid->cellSize = cellSize;
+    grid->cellsX = (int)(width / cellSize) + 1;
+    grid->cellsZ = (int)(length / cellSize) + 1;
+    grid->originX = -width / 2;
+    grid->originZ = -length / 2;
+    grid->cellStart = calloc(grid->cellsX * grid->cellsZ + 1, sizeof(int));
+    grid->maxPlayers = maxPlayers;
+    grid->ownerStart = calloc(maxPlayers + 1, sizeof(int));
+}
+
+void FreeInterestGrid(InterestGrid *grid) {
+    free(grid->cellStart);
+    free(grid->byCell);
+    free(grid->cellOf);
+    free(grid->x);
+    free(grid->z);
+    free(grid->ownerStart);
+    free(grid->byOwner);
+    free(grid->marks);
+    free(grid->selected);
+    memset(grid, 0, sizeof(*grid));
+}
+
+static int ClampCell(int cell, int cells) {
+    if (cell < 0) return 0;
+    if (cell >= cells) return cells - 1;
+    return cell;
+}
+
+static void ReserveInterest(InterestGrid *grid, int count) {
+    if (count <= grid->capacity) return;
+    int capacity = grid->capacity ? grid->capacity : 256;
+    while (capacity < count) capacity *= 2;
+    grid->byCell = realloc(grid->byCell, capacity * sizeof(int));
+    grid->cellOf = realloc(grid->cellOf, capacity * sizeof(int));
+    grid->x = realloc(grid->x, capacity * sizeof(float));
+    grid->z = realloc(grid->z, capacity * sizeof(float));
+    grid->byOwner = realloc(grid->byOwner, capacity * sizeof(int));
+    grid->selected = realloc(grid->selected, capacity * sizeof(int));
+    // Cleared again by every GatherInterest, so only the new words need zeroing
+    int words = grid->capacity / 64;
+    grid->marks = realloc(grid->marks, capacity / 64 * sizeof(uint64_t));
+    memset(grid->marks + words, 0, (capacity / 64 - words) * sizeof(uint64_t));
+    grid->capacity = capacity;
+}
+
+void BuildInterestGrid(InterestGrid *grid, const NetSnapshot *world, int tickRate) {
+    ReserveInterest(grid, world->count);
+    int cellCount = grid->cellsX * grid->cellsZ;
+    int *start = grid->cellStart;
+    int *ownerStart = grid->ownerStart;
+    memset(start, 0, (cellCount + 1) * sizeof(int));
+    memset(ownerStart, 0, (grid->maxPlayers + 1) * sizeof(int));
+
+    for (int i = 0; i < world->count; i++) {
+        const NetEntity *entity = &world->entities[i];
+        if (entity->kind == ENTITY_CANNONBALL) {
+            Vec3 position = GetNetCannonballPosition(entity, world->tick, tickRate);
+            grid->x[i] = position.x;
+            grid->z[i] = position.z;
+            if (entity->value < grid->maxPlayers) ownerStart[entity->value + 1]++;
+        } else {
+            grid->x[i] = DequantizePosition(entity->position[0]);
+            grid->z[i] = DequantizePosition(entity->position[2]);
+        }
+        // Anything off the plane lands in the border cells
+        int cx = ClampCell((int)((grid->x[i] - grid->originX) / grid->cellSize), grid->cellsX);
+        int cz = ClampCell((int)((grid->z[i] - grid->originZ) / grid->cellSize), grid->cellsZ);
+        grid->cellOf[i] = cz * grid->cellsX + cx;
+        start[grid->cellOf[i] + 1]++;
+    }
+
+    // Counting sorts by cell and by owner; both stable, so each bucket stays in snapshot order
+    for (int c = 0; c < cellCount; c++) start[c + 1] += start[c];
+    for (int p = 0; p < grid->maxPlayers; p++) ownerStart[p + 1] += ownerStart[p];
+    for (int i = 0; i < world->count; i++) {
+        grid->byCell[start[grid->cellOf[i]]++] = i;
+        const NetEntity *entity = &world->entities[i];
+        if (entity->kind == ENTITY_CANNONBALL && entity->value < grid->maxPlayers) {
+            grid->byOwner[ownerStart[entity->value]++] = i;
+        }
+    }
+    // The scatters advanced every start to the next bucket's; shift them back
+    memmove(start + 1, start, cellCount * sizeof(int));
+    start[0] = 0;
+    memmove(ownerStart + 1, ownerStart, grid->maxPlayers * sizeof(int));
+    ownerStart[0] = 0;
+}
+
+void GatherInterest(InterestGrid *grid, const NetSnapshot *world, int playerId, float x, float z, float radius, NetSnapshot *out) {
+    int minX = ClampCell((int)((x - radius - grid->originX) / grid->cellSize), grid->cellsX);
+    int maxX = ClampCell((int)((x + radius - grid->originX) / grid->cellSize), grid->cellsX);
+    int minZ = ClampCell((int)((z - radius - grid->originZ) / grid->cellSize), grid->cellsZ);
+    int maxZ = ClampCell((int)((z + radius - grid->originZ) / grid->cellSize), grid->cellsZ);
+
+    uint64_t *marks = grid->marks;
+    float radiusSq = radius * radius;
+    for (int cz = minZ; cz <= maxZ; cz++) {
+        // Cells of one row are adjacent in byCell, so the row is one run
+        int begin = grid->cellStart[cz * grid->cellsX + minX];
+        int end = grid->cellStart[cz * grid->cellsX + maxX + 1];
+        for (int k = begin; k < end; k++) {
+            int i = grid->byCell[k];
+            const NetEntity *entity = &world->entities[i];
+            // The player's own cannonballs are added below
+            if (entity->kind == ENTITY_CANNONBALL && entity->value == playerId) continue;
+            float dx = grid->x[i] - x, dz = grid->z[i] - z;
+            if (dx * dx + dz * dz <= radiusSq || (entity->kind == ENTITY_BOAT && entity->id == playerId)) {
+                marks[i >> 6] |= 1ull << (i & 63);
+            }
+        }
+    }
+    if (playerId >= 0 && playerId < grid->maxPlayers) {
+        for (int k = grid->ownerStart[playerId]; k < grid->ownerStart[playerId + 1]; k++) {
+            int i = grid->byOwner[k];
+            marks[i >> 6] |= 1ull << (i & 63);
+        }
+    }
+
+    // Reading the bits back in order yields ascending snapshot indices without a sort
+    int count = 0;
+    for (int w = 0; w < (world->count + 63) / 64; w++) {
+        for (uint64_t bits = marks[w]; bits; bits &= bits - 1) grid->selected[count++] = w * 64 + __builtin_ctzll(bits);
+        marks[w] = 0;
+    }
+    FilterNetSnapshot(world, grid->selected, count, out);
+}
@@ -0,0 +1,38 @@
+#ifndef INTEREST_H
+#define INTEREST_H
+
+#include "protocol.h"
+
+// Clients hear about entities within this distance of their boat, a little past
+// the default draw distance so spawns and despawns happen out of sight
+#define INTEREST_RADIUS 160.0f
+#define INTEREST_CELL_SIZE 32.0f
+
+// Grid over the water plane bucketing one tick's entities by where they are,
+// so each client's area of interest only visits nearby cells. Rebuilt every tick.
+typedef struct {
+    float originX, originZ;    // corner of cell (0, 0)
+    float cellSize;
+    int cellsX, cellsZ;
+    int *cellStart;            // cellsX * cellsZ + 1 offsets into byCell
+    int *byCell;               // snapshot indices sorted by cell, ascending within a cell
+    int *cellOf;               // cell of each snapshot index
+    float *x, *z;              // position of each snapshot index this tick
+    int maxPlayers;
+    int *ownerStart;           // maxPlayers + 1 offsets into byOwner
+    int *byOwner;              // cannonball snapshot indices sorted by owner
+    uint64_t *marks;           // scratch for GatherInterest: one bit per snapshot index
+    int *selected;             // GatherInterest's result as snapshot indices
+    int capacity;
+} InterestGrid;
+
+void InitInterestGrid(InterestGrid *grid, float width, float length, float cellSize, int maxPlayers);
+void FreeInterestGrid(InterestGrid *grid);
+// Buckets every entity of the snapshot, cannonballs at their position at the snapshot's tick
+void BuildInterestGrid(InterestGrid *grid, const NetSnapshot *world, int tickRate);
+// Fills `out` with the entities within `radius` of (x, z) plus every cannonball
+// `playerId` owns, which its client predicts and must be able to match.
+// grid->selected keeps each one's index in `world` until the next call.
+void GatherInterest(InterestGrid *grid, const NetSnapshot *world, int playerId, float x, float z, float radius, NetSnapshot *out);
+
+#endif
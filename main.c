@@ -1,5 +1,15 @@
 #include "raylib.h"
 #include "raymath.h"
+#include "ocean.h"
+#include "sim.h"
+#include "protocol.h"
+#include "client.h"
+#include "server.h"
+#include "assets.h"
+#include "mesh.h"
+#include "profiler.h"
+#include "quality.h"
+#include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -10,69 +20,51 @@
 #include <pthread.h>
 #include <time.h>
 
-#define NUM_SPRINKLES 10000
-#define MAX_CLIENTS 10
-#define MAX_CANNONBALLS 50
-#define MAX_HEALTH 100
-#define CANNONBALL_DAMAGE 20
-#define CANNONBALL_SPEED 0.2f
-
-typedef struct {
-    float x, y, z;
-} BoatPosition;
-
-typedef struct {
-    Vector3 position;
-    Vector3 direction;
-    bool active;
-} Cannonball;
-
-typedef struct {
-    BoatPosition position;
-    int health;
-    bool active;
-    Cannonball cannonballs[MAX_CANNONBALLS];
-} Player;
-
-typedef struct {
-    pthread_mutex_t mutex;
-    bool serverRunning;
-    int serverPort;
-    char serverIp[INET_ADDRSTRLEN];
-    Player players[MAX_CLIENTS];
-} ServerData;
-
-// Global array for sprinkles
-Vector3 sprinkles[NUM_SPRINKLES];
-
-void *ServerMode(void *args);
+#define BOAT_MODEL_PATH "boat.obj"
+#define BOAT_CULL_RADIUS 5.0f
+// Camera distances where other boats drop to the next coarser baked level
+static const float boatLodDistances[MESH_MAX_LODS - 1] = {25.0f, 60.0f};
+#define CANNONBALL_RADIUS 0.2f
+#define PROFILE_CSV_PATH "profile.csv"
+// Every telemetry window of the connection to the server, when joined
+#define TELEMETRY_CSV_PATH "telemetry.csv"
+// The frame rate the quality governor holds the game to
+#define TARGET_FPS 60
+
+// Sprinkle tiles streamed in around the camera
+Ocean ocean;
+
+// Bucket grid over the water plane and the culling counters of the last frame
+CullGrid cullGrid;
+CullStats cullStats;
+
 void ClientMode(const char *ip_address, int port);
 void DrawMainMenu(bool *isHosting, bool *isJoining, char *ipAddressBuffer, char *portBuffer, ServerData *serverData, int *focusedInput);
 char *GetLocalIPAddress();
-void RunGame(Player *player, ServerData *serverData, bool isHost, int clientId);
+void RunGame(Sim *sim, NetClient *net, int clientId);
+void DrawProfileOverlay(int x, int bottom);
+void DrawNetStatsOverlay(const LinkStats *stats, int right, int y);
 
 int main(void) {
     const int screenWidth = 800;
     const int screenHeight = 600;
     InitWindow(screenWidth, screenHeight, "boaties, floaties, and cannons!");
 
-    // Initialize sprinkles array
-    Vector2 waterSize = {400.0f, 400.0f};
-    for (int i = 0; i < NUM_SPRINKLES; i++) {
-        sprinkles[i].x = (float)rand() / (float)(RAND_MAX / waterSize.x) - waterSize.x / 2;
-        sprinkles[i].y = -0.95f;
-        sprinkles[i].z = (float)rand() / (float)(RAND_MAX / waterSize.y) - waterSize.y / 2;
-    }
+    // Boats and cannonballs stay on the simulated water; the ocean around it is endless
+    Vector2 waterSize = {WATER_WIDTH, WATER_LENGTH};
+    InitCullGrid(&cullGrid, waterSize, CULL_CELL_SIZE);
+    LoadOcean(&ocean, OCEAN_SEED);
+    // Held for the whole session so starting another game reuses the uploaded mesh
+    Model *boat = AcquireModel(BOAT_MODEL_PATH);
 
     bool isHosting = false, isJoining = false;
     char ipAddressBuffer[64] = {0}, portBuffer[6] = {0};
     int focusedInput = 0;  // 0 = IP input, 1 = Port input
+    static Sim sim;
     ServerData serverData;
-    pthread_mutex_init(&serverData.mutex, NULL);
-    serverData.serverRunning = false;
-    serverData.serverPort = 0;
+    InitServerData(&serverData, &sim);
 
-    SetTargetFPS(60);
+    SetTargetFPS(TARGET_FPS);
 
     while (!WindowShouldClose()) {
         BeginDrawing();
@@ -88,30 +80,19 @@ int main(void) {
                 strncpy(serverData.serverIp, localIp, INET_ADDRSTRLEN);
             }
 
-            pthread_mutex_lock(&serverData.mutex);
-            serverData.serverRunning = true;
-            for (int i = 0; i < MAX_CLIENTS; i++) {
-                serverData.players[i].active = false;
-                serverData.players[i].health = MAX_HEALTH;
-                for (int j = 0; j < MAX_CANNONBALLS; j++) {
-                    serverData.players[i].cannonballs[j].active = false;
-                }
-            }
-            pthread_mutex_unlock(&serverData.mutex);
-
-            pthread_t server_thread;
-            pthread_create(&server_thread, NULL, ServerMode, &serverData);
+            InitSim(&sim, SIM_DEFAULT_TICK_RATE, MAX_CLIENTS);
+            serverData.reservedPlayers = 1;
+            serverData.serverPort = 0;
+            if (!StartServer(&serverData)) printf("Error: Could not open the server port.\n");
             isHosting = false;
 
-            // Run the game for the host
-            serverData.players[0].active = true;
-            RunGame(&serverData.players[0], &serverData, true, 0);
+            // Run the game for the host, who always plays as player 0
+            RunGame(&sim, NULL, 0);
+            StopServer(&serverData);
+            FreeSim(&sim);
         } else if (isJoining) {
             if (strlen(portBuffer) > 0) {
                 ClientMode(ipAddressBuffer, atoi(portBuffer));
-
-                // Run the game for the client
-                RunGame(&serverData.players[1], &serverData, false, 1);
             } else {
                 printf("Error: Please enter a valid port number.\n");
             }
@@ -121,19 +102,31 @@ int main(void) {
         EndDrawing();
     }
 
-    pthread_mutex_lock(&serverData.mutex);
-    serverData.serverRunning = false;
-    pthread_mutex_unlock(&serverData.mutex);
+    StopServer(&serverData);
 
+    if (boat) ReleaseModel(boat);
+    UnloadOcean(&ocean);
+    FreeCullGrid(&cullGrid);
     CloseWindow();
 
     return 0;
 }
 
-void RunGame(Player *player, ServerData *serverData, bool isHost, int clientId) {
-    Vector2 waterSize = {400.0f, 400.0f};
-    Model boat = LoadModel("boat.obj");
+// Renders the world and feeds the local player's input into it. The world comes
+// either from a local simulation, whose thread is started here and stopped by
+// the caller, or from a server through the client's network thread.
+void RunGame(Sim *sim, NetClient *net, int clientId) {
+    Model *boat = AcquireModel(BOAT_MODEL_PATH);
+    if (!boat) return;
     float boatScale = 0.07f;
+    bool showCullStats = false;
+    bool showProfile = false;
+    bool showNetStats = false;
+    // Boats bob on the same waves as the sprinkles; only how they are drawn, never the simulation
+    bool boatsRideWaves = true;
+    // Starts at full detail and backs off only if this machine can't keep up
+    QualityGovernor quality;
+    InitQualityGovernor(&quality, 1000.0f / TARGET_FPS, QUALITY_LEVELS - 1);
 
     Camera3D camera = { 0 };
     camera.position = (Vector3){ 0.0f, 1.5f, 6.0f };
@@ -142,11 +135,33 @@ void RunGame(Player *player, ServerData *serverData, bool isHost, int clientId)
     camera.fovy = 45.0f;
     camera.projection = CAMERA_PERSPECTIVE;
 
+    PlayerInput input = { .connected = true };
+    int snapshotReader = -1;
+    WorldSnapshot netWorld = {0};
+    static SnapshotInterpolator interp;
+    if (sim) {
+        snapshotReader = OpenSnapshotReader(sim);
+        StartSimThread(sim);
+    } else {
+        InitWorldSnapshot(&netWorld, net->maxPlayers);
+        InitInterpolator(&interp, net->tickRate, CLIENT_DEFAULT_INTERP_DELAY_MS);
+    }
+    // Level each boat was drawn at last frame, for the LOD hysteresis
+    int lodCount = GetModelLodCount(boat);
+    int *boatLods = calloc(sim ? sim->maxPlayers : net->maxPlayers, sizeof(int));
+
+    PROFILE_BEGIN(PHASE_FRAME);
+
     while (!WindowShouldClose()) {
         // If the window should close, break out of the loop
         if (WindowShouldClose()) break;
 
+        double frameStart = GetTime();
+        const QualitySettings *settings = GetQualitySettings(quality.level);
+        float drawDistance = CULL_DEFAULT_DRAW_DISTANCE * settings->drawDistanceScale;
+
         // Update camera and boat position
+        PROFILE_BEGIN(PHASE_FRAME_INPUT);
         Vector3 direction = Vector3Subtract(camera.target, camera.position);
         direction = Vector3Normalize(direction);
         Vector3 moveStep = Vector3Scale(direction, 0.1f);
@@ -154,101 +169,179 @@ void RunGame(Player *player, ServerData *serverData, bool isHost, int clientId)
         camera.target = Vector3Add(camera.target, moveStep);
         UpdateCamera(&camera, CAMERA_FIRST_PERSON);
 
-        player->position.x = camera.position.x;
-        player->position.y = camera.position.y;
-        player->position.z = camera.position.z - 2.5f;
-
+        input.position.x = Clamp(camera.position.x, -WORLD_HALF_EXTENT, WORLD_HALF_EXTENT);
+        input.position.y = camera.position.y;
+        input.position.z = Clamp(camera.position.z - 2.5f, -WORLD_HALF_EXTENT, WORLD_HALF_EXTENT);
+        // The sim holds boats inside the world bound, so the camera stops there with the boat
+        Vector3 correction = {input.position.x - camera.position.x, 0.0f, input.position.z + 2.5f - camera.position.z};
+        camera.position = Vector3Add(camera.position, correction);
+        camera.target = Vector3Add(camera.target, correction);
+        input.aim = (Vec3){direction.x, direction.y, direction.z};
         if (IsKeyPressed(KEY_SPACE)) {
-            for (int i = 0; i < MAX_CANNONBALLS; i++) {
-                if (!player->cannonballs[i].active) {
-                    player->cannonballs[i].position = (Vector3){player->position.x, player->position.y, player->position.z};
-                    player->cannonballs[i].direction = direction;
-                    player->cannonballs[i].active = true;
-                    break;
-                }
-            }
-        }
-
-        // Update cannonballs
-        for (int i = 0; i < MAX_CANNONBALLS; i++) {
-            if (player->cannonballs[i].active) {
-                player->cannonballs[i].position = Vector3Add(player->cannonballs[i].position,
-                                                             Vector3Scale(player->cannonballs[i].direction, CANNONBALL_SPEED));
-                if (player->cannonballs[i].position.z < -waterSize.y / 2 ||
-                    player->cannonballs[i].position.z > waterSize.y / 2 ||
-                    player->cannonballs[i].position.x < -waterSize.x / 2 ||
-                    player->cannonballs[i].position.x > waterSize.x / 2) {
-                    player->cannonballs[i].active = false;
-                }
-            }
+            input.shots++;
+            if (net) PredictShot(&interp, (Vec3){input.position.x, input.position.y, input.position.z}, input.aim);
         }
 
-        // Check for hits
-        if (isHost) {
-            for (int i = 0; i < MAX_CLIENTS; i++) {
-                if (serverData->players[i].active && i != clientId) {
-                    for (int j = 0; j < MAX_CANNONBALLS; j++) {
-                        if (player->cannonballs[j].active &&
-                            Vector3Distance((Vector3){serverData->players[i].position.x, serverData->players[i].position.y, serverData->players[i].position.z},
-                                            player->cannonballs[j].position) < 1.0f) {
-                            serverData->players[i].health -= CANNONBALL_DAMAGE;
-                            player->cannonballs[j].active = false;
-                            if (serverData->players[i].health <= 0) {
-                                serverData->players[i].health = 0;
-                                serverData->players[i].active = false;
-                            }
-                        }
-                    }
-                }
+        PROFILE_END(PHASE_FRAME_INPUT);
+
+        // Gameplay runs on the simulation thread or the server; draw whatever it published last
+        PROFILE_BEGIN(PHASE_FRAME_WORLD);
+        const WorldSnapshot *world = &netWorld;
+        if (sim) {
+            SubmitInput(sim, clientId, &input);
+            world = AcquireSnapshot(sim, snapshotReader);
+        } else {
+            // Remote boats play back a little in the past so late packets still arrive in time
+            if (IsKeyPressed(KEY_LEFT_BRACKET) && interp.delayMs > 0) interp.delayMs -= 10;
+            if (IsKeyPressed(KEY_RIGHT_BRACKET)) interp.delayMs += 10;
+            SubmitClientInput(net, &input);
+            ReceiveFrames(&interp, net);
+            // The server shut down or dropped us; back to the menu rather than a frozen world
+            if (IsServerLost(&interp, net)) {
+                printf("Error: Lost the connection to the server.\n");
+                break;
             }
+            InterpolateWorld(&interp, GetFrameTime(), clientId, &netWorld);
         }
-
-        // Regenerate health
-        if (player->health < MAX_HEALTH) {
-            player->health += 1;
-        }
+        const Player *player = &world->players[clientId];
+        PROFILE_END(PHASE_FRAME_WORLD);
+
+        if (IsKeyPressed(KEY_F3)) showCullStats = !showCullStats;
+        if (IsKeyPressed(KEY_F4)) showProfile = !showProfile;
+        if (IsKeyPressed(KEY_F5) && !ExportProfileCsv(PROFILE_CSV_PATH)) printf("Error: Could not write %s.\n", PROFILE_CSV_PATH);
+        if (IsKeyPressed(KEY_F6)) boatsRideWaves = !boatsRideWaves;
+        if (IsKeyPressed(KEY_F7) && net) showNetStats = !showNetStats;
+        WaveClock waves = GetWaveClock(GetTime());
+
+        PROFILE_BEGIN(PHASE_FRAME_CULL);
+        Frustum frustum = GetCameraFrustum(camera, (float)GetScreenWidth() / GetScreenHeight(), drawDistance);
+        UpdateCullGrid(&cullGrid, &frustum, camera.position, drawDistance, &cullStats);
+        UpdateOcean(&ocean, camera.position, drawDistance);
+        PROFILE_END(PHASE_FRAME_CULL);
 
         BeginDrawing();
         ClearBackground(SKYBLUE);
         BeginMode3D(camera);
-        DrawModel(boat, (Vector3){player->position.x, player->position.y, player->position.z}, boatScale, BROWN);
-        Vector3 waterPosition = {0.0f, -1.0f, 0.0f};
-        DrawPlane(waterPosition, waterSize, BLUE);
-
-        for (int i = 0; i < NUM_SPRINKLES; i++) {
-            DrawCube(sprinkles[i], 0.5f, 0.05f, 0.2f, DARKBLUE);
-        }
-
-        // Draw cannonballs
-        for (int i = 0; i < MAX_CANNONBALLS; i++) {
-            if (player->cannonballs[i].active) {
-                DrawSphere(player->cannonballs[i].position, 0.2f, BLACK);
+        // The local boat follows the camera directly rather than waiting a tick for the sim
+        float bob = boatsRideWaves ? WaveHeight(&waves, input.position.x, input.position.z) : 0.0f;
+        DrawModel(*boat, (Vector3){input.position.x, input.position.y + bob, input.position.z}, boatScale, BROWN);
+        // The water follows the camera in whole tiles and reaches past the draw distance
+        Vector3 waterPosition = {roundf(camera.position.x / OCEAN_TILE_SIZE) * OCEAN_TILE_SIZE, -1.0f,
+                                 roundf(camera.position.z / OCEAN_TILE_SIZE) * OCEAN_TILE_SIZE};
+        float waterExtent = 2.0f * (drawDistance + OCEAN_TILE_SIZE);
+        DrawPlane(waterPosition, (Vector2){waterExtent, waterExtent}, BLUE);
+
+        PROFILE_BEGIN(PHASE_FRAME_SPRINKLES);
+        DrawOcean(&ocean, &frustum, camera.position, drawDistance, settings->sprinkleDensity, &waves, DARKBLUE, &cullStats);
+        PROFILE_END(PHASE_FRAME_SPRINKLES);
+
+        // Draw cannonballs, only live ones are in the pool's dense range
+        PROFILE_BEGIN(PHASE_FRAME_CANNONBALLS);
+        const ProjectilePool *projectiles = &world->projectiles;
+        for (int i = 0; i < projectiles->count; i++) {
+            Vector3 center = {projectiles->position[i].x, projectiles->position[i].y, projectiles->position[i].z};
+            if (!IsSphereVisible(&cullGrid, &frustum, camera.position, drawDistance, center, CANNONBALL_RADIUS)) {
+                cullStats.culledObjects++;
+                continue;
             }
+            cullStats.visibleObjects++;
+            DrawSphereEx(center, CANNONBALL_RADIUS, settings->sphereRings, settings->sphereSlices, BLACK);
         }
+        PROFILE_END(PHASE_FRAME_CANNONBALLS);
 
         // Draw other players
-        if (isHost) {
-            for (int i = 1; i < MAX_CLIENTS; i++) {
-                if (serverData->players[i].active) {
-                    DrawModel(boat, (Vector3){serverData->players[i].position.x, serverData->players[i].position.y, serverData->players[i].position.z}, boatScale, DARKGRAY);
-                    DrawRectangle((int)(serverData->players[i].position.x - 0.5f), (int)(serverData->players[i].position.z - 2.5f),
-                                  (int)(MAX_HEALTH * 0.1f), 5, RED);
-                    DrawRectangle((int)(serverData->players[i].position.x - 0.5f), (int)(serverData->players[i].position.z - 2.5f),
-                                  (int)(serverData->players[i].health * 0.1f), 5, GREEN);
-                }
+        PROFILE_BEGIN(PHASE_FRAME_BOATS);
+        for (int i = 0; i < world->playerCount; i++) {
+            const Player *other = &world->players[i];
+            if (i == clientId || !other->active) continue;
+
+            Vector3 boatCenter = {other->position.x, other->position.y, other->position.z};
+            if (!IsSphereVisible(&cullGrid, &frustum, camera.position, drawDistance, boatCenter, BOAT_CULL_RADIUS)) {
+                cullStats.culledObjects++;
+                continue;
             }
+            cullStats.visibleObjects++;
+            boatLods[i] = SelectLod(boatLods[i], Vector3Distance(camera.position, boatCenter), boatLodDistances, lodCount);
+            if (boatsRideWaves) boatCenter.y += WaveHeight(&waves, boatCenter.x, boatCenter.z);
+            DrawModelLod(boat, boatLods[i], boatCenter, boatScale, DARKGRAY);
+            DrawRectangle((int)(other->position.x - 0.5f), (int)(other->position.z - 2.5f),
+                          (int)(MAX_HEALTH * 0.1f), 5, RED);
+            DrawRectangle((int)(other->position.x - 0.5f), (int)(other->position.z - 2.5f),
+                          (int)(other->health * 0.1f), 5, GREEN);
         }
         EndMode3D();
+        PROFILE_END(PHASE_FRAME_BOATS);
 
         // Draw health bar for the player
+        PROFILE_BEGIN(PHASE_FRAME_HUD);
         DrawRectangle(10, GetScreenHeight() - 40, MAX_HEALTH, 20, RED);
         DrawRectangle(10, GetScreenHeight() - 40, player->health, 20, GREEN);
         DrawText("Health", 10, GetScreenHeight() - 60, 20, DARKGRAY);
 
+        if (showCullStats) {
+            DrawText(TextFormat("Visible: %d  Culled: %d  Cells: %d/%d", cullStats.visibleObjects, cullStats.culledObjects,
+                                cullStats.visibleCells, cullStats.visibleCells + cullStats.culledCells),
+                     10, 10, 20, DARKGRAY);
+            DrawText(TextFormat("Tick: %u  %.3f ms  Overruns: %u", world->tick, world->tickNs / 1e6, world->overruns),
+                     10, 35, 20, DARKGRAY);
+            DrawText(TextFormat("Ocean tiles built: %d  evicted: %d", ocean.tilesBuilt, ocean.tilesEvicted), 10, 60, 20, DARKGRAY);
+            DrawText(TextFormat("Quality: %s (%d/%d)  changes: %d", settings->name, quality.level, QUALITY_LEVELS - 1, quality.changes),
+                     10, 85, 20, DARKGRAY);
+            if (net) DrawText(TextFormat("Interpolation delay: %d ms  [ ]", interp.delayMs), 10, 110, 20, DARKGRAY);
+        }
+        if (showProfile) DrawProfileOverlay(MAX_HEALTH + 30, GetScreenHeight() - 20);
+        if (showNetStats) DrawNetStatsOverlay(GetClientStats(net), GetScreenWidth() - 10, 10);
+        PROFILE_END(PHASE_FRAME_HUD);
+
+        // Everything up to here is this frame's own work; EndDrawing adds the wait for the target rate
+        float workMs = (float)((GetTime() - frameStart) * 1000.0);
         EndDrawing();
+        if (UpdateQualityGovernor(&quality, GetFrameTime() * 1000.0f, workMs)) {
+            TraceLog(LOG_INFO, "QUALITY: %s (level %d), frame %.1f ms, work %.1f ms", GetQualitySettings(quality.level)->name,
+                     quality.level, GetFrameTime() * 1000.0f, workMs);
+        }
+        PROFILE_END(PHASE_FRAME);
+        PROFILE_BEGIN(PHASE_FRAME);
     }
 
-    UnloadModel(boat);
+    if (net) FreeInterpolator(&interp);
+    FreeWorldSnapshot(&netWorld);
+    free(boatLods);
+    ReleaseModel(boat);
+}
+
+// Phase timings of the last PROFILE_HISTORY samples and the running counters,
+// stacked upwards from `bottom`
+void DrawProfileOverlay(int x, int bottom) {
+    int y = bottom - 12;
+    for (int counter = COUNTER_COUNT - 1; counter >= 0; counter--, y -= 12) {
+        DrawText(TextFormat("%-18s %llu", GetCounterName(counter), (unsigned long long)profileCounters[counter]), x, y, 10, DARKGRAY);
+    }
+    for (int phase = PHASE_COUNT - 1; phase >= 0; phase--) {
+        PhaseStats stats;
+        GetPhaseStats(phase, &stats);
+        if (stats.count == 0) continue;
+        DrawText(TextFormat("%-18s %8.1f %8.1f %8.1f %8.1f", GetPhaseName(phase), stats.minUs, stats.meanUs, stats.p99Us, stats.maxUs),
+                 x, y, 10, DARKGRAY);
+        y -= 12;
+    }
+    DrawText("phase (us)              min     mean      p99      max   F5: CSV", x, y, 10, DARKGRAY);
+}
+
+static void DrawTextRight(const char *text, int right, int y) {
+    DrawText(text, right - MeasureText(text, 20), y, 20, DARKGRAY);
+}
+
+// The connection's latest telemetry window, right-aligned to `right`
+void DrawNetStatsOverlay(const LinkStats *stats, int right, int y) {
+    DrawTextRight(TextFormat("RTT: %.1f ms  jitter: %.1f ms  loss: %.0f%%", stats->rttUs / 1000.0f, stats->jitterUs / 1000.0f,
+                             stats->pingLoss * 100.0f), right, y);
+    DrawTextRight(TextFormat("Up: %.1f kB/s  %.0f msg/s", stats->bytesSentPerSecond / 1000.0f, stats->messagesSentPerSecond),
+                  right, y + 25);
+    DrawTextRight(TextFormat("Down: %.1f kB/s  %.0f msg/s", stats->bytesReceivedPerSecond / 1000.0f,
+                             stats->messagesReceivedPerSecond), right, y + 50);
+    DrawTextRight(TextFormat("Send queue: %d B  dropped: %u", stats->sendQueueBytes, stats->messagesDropped), right, y + 75);
+    DrawTextRight(TextFormat("Server tick: %.3f ms  overruns: %u", stats->tickUs / 1000.0f, stats->overruns), right, y + 100);
 }
 
 void DrawMainMenu(bool *isHosting, bool *isJoining, char *ipAddressBuffer, char *portBuffer, ServerData *serverData, int *focusedInput) {
@@ -351,153 +444,15 @@ char *GetLocalIPAddress() {
     return ip;
 }
 
-void *ServerMode(void *args) {
-    ServerData *serverData = (ServerData *)args;
-    int server_fd, new_socket, client_sockets[MAX_CLIENTS] = {0};
-    struct sockaddr_in address = {.sin_family = AF_INET, .sin_addr.s_addr = INADDR_ANY};
-    int addrlen = sizeof(address);
-
-    srand(time(NULL));
-    pthread_mutex_lock(&serverData->mutex);
-    serverData->serverPort = rand() % (65535 - 1024) + 1024;
-    int serverPort = serverData->serverPort;
-    pthread_mutex_unlock(&serverData->mutex);
-
-    address.sin_port = htons(serverPort);
-    if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) == 0 || bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(server_fd, 3) < 0) {
-        pthread_mutex_lock(&serverData->mutex);
-        serverData->serverRunning = false;
-        pthread_mutex_unlock(&serverData->mutex);
-        return NULL;
-    }
-
-    while (1) {
-        pthread_mutex_lock(&serverData->mutex);
-        if (!serverData->serverRunning) {
-            pthread_mutex_unlock(&serverData->mutex);
-            break;
-        }
-        pthread_mutex_unlock(&serverData->mutex);
-
-        fd_set readfds;
-        FD_ZERO(&readfds);
-        FD_SET(server_fd, &readfds);
-        int max_sd = server_fd;
-
-        for (int i = 0; i < MAX_CLIENTS; i++) {
-            int sd = client_sockets[i];
-            if (sd > 0) FD_SET(sd, &readfds);
-            if (sd > max_sd) max_sd = sd;
-        }
-
-        if (select(max_sd + 1, &readfds, NULL, NULL, NULL) < 0) continue;
-        if (FD_ISSET(server_fd, &readfds)) {
-            if ((new_socket = accept(server_fd, (struct sockaddr *)&address, (socklen_t *)&addrlen)) < 0) continue;
-            for (int i = 0; i < MAX_CLIENTS; i++) {
-                if (client_sockets[i] == 0) {
-                    client_sockets[i] = new_socket;
-                    serverData->players[i].active = true;
-                    break;
-                }
-            }
-        }
-
-        for (int i = 0; i < MAX_CLIENTS; i++) {
-            int sd = client_sockets[i];
-            if (FD_ISSET(sd, &readfds)) {
-                BoatPosition boatPos;
-                int valread = read(sd, &boatPos, sizeof(BoatPosition));
-                if (valread == 0) {
-                    close(sd);
-                    client_sockets[i] = 0;
-                    serverData->players[i].active = false;
-                } else {
-                    pthread_mutex_lock(&serverData->mutex);
-                    serverData->players[i].position = boatPos;
-                    pthread_mutex_unlock(&serverData->mutex);
-                }
-            }
-        }
-    }
-
-    close(server_fd);
-    return NULL;
-}
-
 void ClientMode(const char *ip_address, int port) {
-    int sock = 0;
-    struct sockaddr_in serv_addr = {.sin_family = AF_INET, .sin_port = htons(port)};
-
-    if ((sock = socket(AF_INET, SOCK_STREAM, 0)) < 0 || inet_pton(AF_INET, ip_address, &serv_addr.sin_addr) <= 0 || connect(sock, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
-        printf("Error: Connection to server failed.\n");
-        return;
-    }
-
-    Player player = {0};
-    player.health = MAX_HEALTH;
-    fd_set readfds;
-
-    while (!WindowShouldClose()) {
-        FD_ZERO(&readfds);
-        FD_SET(sock, &readfds);
-        struct timeval timeout = {.tv_sec = 1, .tv_usec = 0};
-
-        if (select(sock + 1, &readfds, NULL, NULL, &timeout) < 0) {
-            printf("Error: Select failed.\n");
-            break;
-        }
-
-        if (FD_ISSET(sock, &readfds)) {
-            BoatPosition receivedPos;
-            int valread = recv(sock, &receivedPos, sizeof(BoatPosition), 0);
-            if (valread <= 0) {
-                printf("Error: Failed to receive data from server or server closed connection.\n");
-                break;
-            }
-
-            player.position = receivedPos;
-        }
-
-        send(sock, &player.position, sizeof(BoatPosition), 0);
-
-        // Simulate boat movement
-        Vector3 direction = Vector3Subtract((Vector3){player.position.x, player.position.y, player.position.z}, (Vector3){0, 0, 0});
-        direction = Vector3Normalize(direction);
-        Vector3 moveStep = Vector3Scale(direction, 0.1f);
-        Vector3 newPosition = Vector3Add((Vector3){player.position.x, player.position.y, player.position.z}, moveStep);
-        player.position.x = newPosition.x;
-        player.position.y = newPosition.y;
-        player.position.z = newPosition.z;
-
-        // Run the same gameplay loop as the host
-        RunGame(&player, NULL, false, 0); // Pass `NULL` for `serverData` as client doesn't control other players
-
-        BeginDrawing();
-        ClearBackground(SKYBLUE);
-
-        // Camera and drawing logic
-        Camera3D camera = { 0 };
-        camera.position = (Vector3){ player.position.x, player.position.y + 1.5f, player.position.z + 6.0f };
-        camera.target = (Vector3){ player.position.x, player.position.y + 2.5f, player.position.z };
-        camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };
-        camera.fovy = 45.0f;
-        camera.projection = CAMERA_PERSPECTIVE;
-
-        BeginMode3D(camera);
-            DrawModelEx(LoadModel("boat.obj"), (Vector3){player.position.x, player.position.y, player.position.z}, (Vector3){0, 1, 0}, 0, (Vector3){0.07f, 0.07f, 0.07f}, BROWN);
-            Vector3 waterPosition = {0.0f, -1.0f, 0.0f};
-            DrawPlane(waterPosition, (Vector2){400.0f, 400.0f}, BLUE);
-            
-            // Draw the sprinkles 
-            for (int i = 0; i < NUM_SPRINKLES; i++) {
-                DrawCube(sprinkles[i], 0.5f, 0.05f, 0.2f, DARKBLUE);
-            }
-            
-            DrawGrid(10, 1.0f);
-        EndMode3D();
-
-        EndDrawing();
-    }
-
-    close(sock);
+    static NetClient client;
+    static TelemetryLog telemetry;
+    if (!ConnectClient(&client, ip_address, port)) return;
+
+    if (OpenTelemetryLog(&telemetry, TELEMETRY_CSV_PATH)) client.telemetry = &telemetry;
+    else printf("Error: Could not write %s.\n", TELEMETRY_CSV_PATH);
+    StartClientThread(&client);
+    RunGame(NULL, &client, client.playerId);
+    CloseClient(&client);
+    CloseTelemetryLog(&telemetry);
 }
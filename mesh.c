@@ -0,0 +1,261 @@
+#include "mesh.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// OBJ polygons with more corners than this are rejected
+#define OBJ_MAX_FACE_VERTICES 32
+
+static void PushFloat(float **array, int *count, int *capacity, float value) {
+    if (*count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 1024;
+        *array = realloc(*array, *capacity * sizeof(float));
+    }
+    (*array)[(*count)++] = value;
+}
+
+static void PushIndex(uint16_t **array, int *count, int *capacity, uint16_t value) {
+    if (*count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 1024;
+        *array = realloc(*array, *capacity * sizeof(uint16_t));
+    }
+    (*array)[(*count)++] = value;
+}
+
+bool LoadObjMesh(const char *path, MeshData *mesh) {
+    memset(mesh, 0, sizeof(*mesh));
+    FILE *file = fopen(path, "r");
+    if (!file) return false;
+
+    int floatCount = 0, floatCapacity = 0, indexCapacity = 0;
+    bool ok = true;
+    char line[1024];
+
+    while (ok && fgets(line, sizeof(line), file)) {
+        if (line[0] == 'v' && (line[1] == ' ' || line[1] == '\t')) {
+            float x, y, z;
+            if (sscanf(line + 2, "%f %f %f", &x, &y, &z) != 3) {
+                ok = false;
+                break;
+            }
+            PushFloat(&mesh->positions, &floatCount, &floatCapacity, x);
+            PushFloat(&mesh->positions, &floatCount, &floatCapacity, y);
+            PushFloat(&mesh->positions, &floatCount, &floatCapacity, z);
+        } else if (line[0] == 'f' && (line[1] == ' ' || line[1] == '\t')) {
+            // Corners look like "v", "v/vt", "v//vn" or "v/vt/vn"; only v matters here
+            int corners[OBJ_MAX_FACE_VERTICES];
+            int cornerCount = 0;
+            for (char *token = strtok(line + 2, " \t\r\n"); token; token = strtok(NULL, " \t\r\n")) {
+                int index = atoi(token);
+                int vertexCount = floatCount / 3;
+                if (index < 0) index += vertexCount + 1;   // relative to the end
+                if (index < 1 || index > vertexCount || index > 65536 || cornerCount == OBJ_MAX_FACE_VERTICES) {
+                    ok = false;
+                    break;
+                }
+                corners[cornerCount++] = index - 1;
+            }
+            for (int i = 2; ok && i < cornerCount; i++) {
+                PushIndex(&mesh->indices, &mesh->indexCount, &indexCapacity, (uint16_t)corners[0]);
+                PushIndex(&mesh->indices, &mesh->indexCount, &indexCapacity, (uint16_t)corners[i - 1]);
+                PushIndex(&mesh->indices, &mesh->indexCount, &indexCapacity, (uint16_t)corners[i]);
+            }
+        }
+    }
+    fclose(file);
+
+    mesh->vertexCount = floatCount / 3;
+    if (!ok || mesh->vertexCount == 0 || mesh->vertexCount > 65536 || mesh->indexCount == 0) {
+        FreeMeshData(mesh);
+        return false;
+    }
+    return true;
+}
+
+void FreeMeshData(MeshData *mesh) {
+    free(mesh->positions);
+    free(mesh->indices);
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+static void GetBounds(const MeshData *mesh, float *boundsMin, float *boundsMax) {
+    for (int k = 0; k < 3; k++) boundsMin[k] = boundsMax[k] = mesh->positions[k];
+    for (int i = 1; i < mesh->vertexCount; i++) {
+        for (int k = 0; k < 3; k++) {
+            float value = mesh->positions[i * 3 + k];
+            if (value < boundsMin[k]) boundsMin[k] = value;
+            if (value > boundsMax[k]) boundsMax[k] = value;
+        }
+    }
+}
+
+// Orders a triangle's corners smallest first without changing its winding
+static void RotateTriangle(uint16_t *triangle) {
+    while (triangle[0] > triangle[1] || triangle[0] > triangle[2]) {
+        uint16_t first = triangle[0];
+        triangle[0] = triangle[1];
+        triangle[1] = triangle[2];
+        triangle[2] = first;
+    }
+}
+
+static int CompareTriangles(const void *a, const void *b) {
+    const uint16_t *ta = a, *tb = b;
+    for (int k = 0; k < 3; k++) {
+        if (ta[k] != tb[k]) return ta[k] < tb[k] ? -1 : 1;
+    }
+    return 0;
+}
+
+void SimplifyMesh(const MeshData *source, int resolution, MeshData *simplified) {
+    memset(simplified, 0, sizeof(*simplified));
+    float boundsMin[3], boundsMax[3];
+    GetBounds(source, boundsMin, boundsMax);
+    float extent = 0.0f;
+    for (int k = 0; k < 3; k++) {
+        if (boundsMax[k] - boundsMin[k] > extent) extent = boundsMax[k] - boundsMin[k];
+    }
+    float cellSize = extent > 0.0f ? extent / resolution : 1.0f;
+
+    int cells[3], cellCount = 1;
+    for (int k = 0; k < 3; k++) {
+        cells[k] = (int)((boundsMax[k] - boundsMin[k]) / cellSize) + 1;
+        cellCount *= cells[k];
+    }
+
+    // Number the occupied cells in first-use order; each becomes one output vertex
+    int *clusterOfCell = malloc(cellCount * sizeof(int));
+    int *clusterOf = malloc(source->vertexCount * sizeof(int));
+    int *clusterSize = calloc(source->vertexCount, sizeof(int));
+    simplified->positions = calloc(source->vertexCount * 3, sizeof(float));
+    memset(clusterOfCell, -1, cellCount * sizeof(int));
+
+    for (int i = 0; i < source->vertexCount; i++) {
+        const float *position = source->positions + i * 3;
+        int cell = 0;
+        for (int k = 2; k >= 0; k--) {
+            int c = (int)((position[k] - boundsMin[k]) / cellSize);
+            if (c >= cells[k]) c = cells[k] - 1;
+            cell = cell * cells[k] + c;
+        }
+        if (clusterOfCell[cell] < 0) clusterOfCell[cell] = simplified->vertexCount++;
+        int cluster = clusterOf[i] = clusterOfCell[cell];
+        for (int k = 0; k < 3; k++) simplified->positions[cluster * 3 + k] += position[k];
+        clusterSize[cluster]++;
+    }
+    for (int c = 0; c < simplified->vertexCount; c++) {
+        for (int k = 0; k < 3; k++) simplified->positions[c * 3 + k] /= clusterSize[c];
+    }
+
+    // Keep triangles whose corners landed in three different clusters, once each
+    simplified->indices = malloc(source->indexCount * sizeof(uint16_t));
+    for (int i = 0; i + 2 < source->indexCount; i += 3) {
+        uint16_t *triangle = simplified->indices + simplified->indexCount;
+        for (int k = 0; k < 3; k++) triangle[k] = (uint16_t)clusterOf[source->indices[i + k]];
+        if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2]) continue;
+        RotateTriangle(triangle);
+        simplified->indexCount += 3;
+    }
+    int triangleCount = simplified->indexCount / 3;
+    qsort(simplified->indices, triangleCount, 3 * sizeof(uint16_t), CompareTriangles);
+    int unique = 0;
+    for (int t = 0; t < triangleCount; t++) {
+        if (unique > 0 && CompareTriangles(simplified->indices + (unique - 1) * 3, simplified->indices + t * 3) == 0) continue;
+        memmove(simplified->indices + unique * 3, simplified->indices + t * 3, 3 * sizeof(uint16_t));
+        unique++;
+    }
+    simplified->indexCount = unique * 3;
+
+    free(clusterOfCell);
+    free(clusterOf);
+    free(clusterSize);
+}
+
+bool WriteMeshBlob(const char *path, const MeshData *lods, int lodCount) {
+    if (lodCount < 1 || lodCount > MESH_MAX_LODS) return false;
+    MeshBlobHeader header = {
+        .magic = MESH_BLOB_MAGIC,
+        .version = MESH_BLOB_VERSION,
+        .lodCount = (uint32_t)lodCount
+    };
+    GetBounds(&lods[0], header.boundsMin, header.boundsMax);
+    for (int l = 0; l < lodCount; l++) {
+        header.lods[l] = (MeshBlobLod){
+            .firstVertex = header.vertexCount,
+            .vertexCount = (uint32_t)lods[l].vertexCount,
+            .firstIndex = header.indexCount,
+            .indexCount = (uint32_t)lods[l].indexCount
+        };
+        header.vertexCount += lods[l].vertexCount;
+        header.indexCount += lods[l].indexCount;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (int l = 0; ok && l < lodCount; l++) {
+        ok = fwrite(lods[l].positions, sizeof(float) * 3, lods[l].vertexCount, file) == (size_t)lods[l].vertexCount;
+    }
+    for (int l = 0; ok && l < lodCount; l++) {
+        ok = fwrite(lods[l].indices, sizeof(uint16_t), lods[l].indexCount, file) == (size_t)lods[l].indexCount;
+    }
+    return fclose(file) == 0 && ok;
+}
+
+// Every level has to lie inside the arrays and index only its own vertices
+static bool CheckMeshBlob(const MeshBlobHeader *header, const uint16_t *indices) {
+    if (header->lodCount < 1 || header->lodCount > MESH_MAX_LODS) return false;
+    for (uint32_t l = 0; l < header->lodCount; l++) {
+        const MeshBlobLod *lod = &header->lods[l];
+        if (lod->firstVertex + lod->vertexCount > header->vertexCount || lod->firstIndex + lod->indexCount > header->indexCount) return false;
+        for (uint32_t i = 0; i < lod->indexCount; i++) {
+            if (indices[lod->firstIndex + i] >= lod->vertexCount) return false;
+        }
+    }
+    return true;
+}
+
+bool MapMeshBlob(const char *path, MappedMesh *mapped) {
+    memset(mapped, 0, sizeof(*mapped));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) < 0 || (size_t)info.st_size < sizeof(MeshBlobHeader)) {
+        close(fd);
+        return false;
+    }
+    void *mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return false;
+
+    const MeshBlobHeader *header = mapping;
+    size_t expected = sizeof(MeshBlobHeader) + (size_t)header->vertexCount * 3 * sizeof(float) + (size_t)header->indexCount * sizeof(uint16_t);
+    if (header->magic != MESH_BLOB_MAGIC || header->version != MESH_BLOB_VERSION || expected != (size_t)info.st_size) {
+        munmap(mapping, info.st_size);
+        return false;
+    }
+
+    const float *positions = (const float *)(header + 1);
+    const uint16_t *indices = (const uint16_t *)(positions + header->vertexCount * 3);
+    if (!CheckMeshBlob(header, indices)) {
+        munmap(mapping, info.st_size);
+        return false;
+    }
+
+    mapped->mapping = mapping;
+    mapped->size = info.st_size;
+    mapped->header = header;
+    mapped->positions = positions;
+    mapped->indices = indices;
+    return true;
+}
+
+void UnmapMeshBlob(MappedMesh *mapped) {
+    if (mapped->mapping) munmap(mapped->mapping, mapped->size);
+    memset(mapped, 0, sizeof(*mapped));
+}
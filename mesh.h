@@ -0,0 +1,65 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MESH_BLOB_MAGIC 0x534D4246     // "FBMS"
+#define MESH_BLOB_VERSION 2
+// Full detail plus up to two simplified levels
+#define MESH_MAX_LODS 3
+
+// Where one detail level sits in the blob; its indices count from its own first vertex
+typedef struct {
+    uint32_t firstVertex;
+    uint32_t vertexCount;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+} MeshBlobLod;
+
+// Baked mesh file: this header, then float positions[vertexCount * 3], then
+// uint16_t indices[indexCount], each holding every level back to back, full
+// detail first. Written in the host's byte order so it can be mapped and
+// handed to the GPU without any parsing.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    float boundsMin[3];
+    float boundsMax[3];
+    uint32_t lodCount;
+    MeshBlobLod lods[MESH_MAX_LODS];
+} MeshBlobHeader;
+
+// Indexed triangle mesh in memory
+typedef struct {
+    float *positions;      // xyz per vertex
+    int vertexCount;
+    uint16_t *indices;     // three per triangle
+    int indexCount;
+} MeshData;
+
+// A baked mesh mapped read-only; the pointers stay valid until UnmapMeshBlob
+typedef struct {
+    void *mapping;
+    size_t size;
+    const MeshBlobHeader *header;
+    const float *positions;
+    const uint16_t *indices;
+} MappedMesh;
+
+// Reads v and f lines of a Wavefront OBJ; polygons are fanned into triangles
+bool LoadObjMesh(const char *path, MeshData *mesh);
+void FreeMeshData(MeshData *mesh);
+// Vertex clustering: snaps vertices to a grid with `resolution` cells along the
+// longest side, merges each cell into its average and drops collapsed triangles
+void SimplifyMesh(const MeshData *source, int resolution, MeshData *simplified);
+
+// Writes lodCount levels of the same model, full detail first
+bool WriteMeshBlob(const char *path, const MeshData *lods, int lodCount);
+bool MapMeshBlob(const char *path, MappedMesh *mapped);
+void UnmapMeshBlob(MappedMesh *mapped);
+
+#endif
@@ -0,0 +1,247 @@
+#include "ocean.h"
+#include "profiler.h"
+#include <math.h>
+#include <string.h>
+
+// Integer-only mixing, so every platform derives identical tiles
+static uint32_t HashTile(uint32_t seed, int x, int z) {
+    uint32_t h = seed ^ ((uint32_t)x * 0x9E3779B1u) ^ ((uint32_t)z * 0x85EBCA77u);
+    h ^= h >> 16;
+    h *= 0x7FEB352Du;
+    h ^= h >> 15;
+    h *= 0x846CA68Bu;
+    h ^= h >> 16;
+    return h ? h : 1;
+}
+
+static uint32_t NextRandom(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// Uniform in [0, 1) from the top 24 bits, exact in a float
+static float RandomUnit(uint32_t *state) {
+    return (NextRandom(state) >> 8) * (1.0f / 16777216.0f);
+}
+
+int GenerateTileSprinkles(uint32_t seed, int tileX, int tileZ, Vector3 *out, int capacity) {
+    uint32_t state = HashTile(seed, tileX, tileZ);
+    // Half to one and a half times the average, so tiles don't look stamped
+    int count = OCEAN_TILE_SPRINKLES / 2 + (int)(NextRandom(&state) % (OCEAN_TILE_SPRINKLES + 1));
+    if (count > capacity) count = capacity;
+    for (int i = 0; i < count; i++) {
+        out[i].x = (tileX + RandomUnit(&state)) * OCEAN_TILE_SIZE;
+        out[i].y = OCEAN_SPRINKLE_Y;
+        out[i].z = (tileZ + RandomUnit(&state)) * OCEAN_TILE_SIZE;
+    }
+    return count;
+}
+
+// Bobs the sprinkles of one even run of the visible tiles
+static void RunWaveTask(void *context, int task) {
+    Ocean *ocean = (Ocean *)context;
+    int begin = task * ocean->visibleCount / ocean->waveTasks;
+    int end = (task + 1) * ocean->visibleCount / ocean->waveTasks;
+    for (int i = begin; i < end; i++) {
+        int index = ocean->visibleTiles[i];
+        // The padding past the tile's last sprinkle gets a height too, nobody reads it
+        int count = (ocean->drawCounts[index] + 7) & ~7;
+        ComputeWaveHeights(&ocean->clock, ocean->sprinkleX[index], ocean->sprinkleZ[index], ocean->heights[index], count);
+    }
+}
+
+void LoadOcean(Ocean *ocean, uint32_t seed) {
+    memset(ocean, 0, sizeof(*ocean));
+    ocean->seed = seed;
+    LoadSprinkleRenderer(&ocean->renderer);
+    for (int i = 0; i < OCEAN_TABLE_SIZE; i++) ocean->table[i] = -1;
+    for (int i = OCEAN_MAX_TILES - 1; i >= 0; i--) ocean->freeTiles[ocean->freeCount++] = i;
+    ocean->lruHead = ocean->lruTail = -1;
+
+    // The render thread takes a share itself, so one helper fewer than there are cores
+    int helpers = GetCoreCount() - 1;
+    if (helpers > 0 && !StartWorkerPool(&ocean->pool, helpers, OCEAN_MAX_TILES, RunWaveTask, ocean)) {
+        TraceLog(LOG_WARNING, "OCEAN: Could not start wave threads, bobbing on the render thread");
+    }
+}
+
+void UnloadOcean(Ocean *ocean) {
+    StopWorkerPool(&ocean->pool);
+    for (int i = 0; i < OCEAN_MAX_TILES; i++) {
+        if (ocean->tiles[i].loaded) UnloadSprinkleBatch(&ocean->renderer, &ocean->tiles[i].batch);
+    }
+    UnloadSprinkleRenderer(&ocean->renderer);
+    memset(ocean, 0, sizeof(*ocean));
+}
+
+static uint32_t TableSlot(int x, int z) {
+    return HashTile(0, x, z) & (OCEAN_TABLE_SIZE - 1);
+}
+
+static int FindTile(const Ocean *ocean, int x, int z) {
+    for (uint32_t slot = TableSlot(x, z);; slot = (slot + 1) & (OCEAN_TABLE_SIZE - 1)) {
+        int index = ocean->table[slot];
+        if (index < 0) return -1;
+        if (ocean->tiles[index].x == x && ocean->tiles[index].z == z) return index;
+    }
+}
+
+static void InsertTile(Ocean *ocean, int index) {
+    uint32_t slot = TableSlot(ocean->tiles[index].x, ocean->tiles[index].z);
+    while (ocean->table[slot] >= 0) slot = (slot + 1) & (OCEAN_TABLE_SIZE - 1);
+    ocean->table[slot] = index;
+}
+
+// Backward-shift deletion keeps every probe chain unbroken without tombstones
+static void RemoveTile(Ocean *ocean, int index) {
+    uint32_t mask = OCEAN_TABLE_SIZE - 1;
+    uint32_t slot = TableSlot(ocean->tiles[index].x, ocean->tiles[index].z);
+    while (ocean->table[slot] != index) slot = (slot + 1) & mask;
+
+    uint32_t next = (slot + 1) & mask;
+    while (ocean->table[next] >= 0) {
+        const OceanTile *tile = &ocean->tiles[ocean->table[next]];
+        uint32_t home = TableSlot(tile->x, tile->z);
+        // Move the entry back if the hole lies between its home slot and where it sits now
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            ocean->table[slot] = ocean->table[next];
+            slot = next;
+        }
+        next = (next + 1) & mask;
+    }
+    ocean->table[slot] = -1;
+}
+
+static void UnlinkTile(Ocean *ocean, int index) {
+    OceanTile *tile = &ocean->tiles[index];
+    if (tile->prev >= 0) ocean->tiles[tile->prev].next = tile->next;
+    else ocean->lruHead = tile->next;
+    if (tile->next >= 0) ocean->tiles[tile->next].prev = tile->prev;
+    else ocean->lruTail = tile->prev;
+}
+
+static void PushTileFront(Ocean *ocean, int index) {
+    OceanTile *tile = &ocean->tiles[index];
+    tile->prev = -1;
+    tile->next = ocean->lruHead;
+    if (ocean->lruHead >= 0) ocean->tiles[ocean->lruHead].prev = index;
+    ocean->lruHead = index;
+    if (ocean->lruTail < 0) ocean->lruTail = index;
+}
+
+// A free tile, or the least recently used one if it is out of range this frame
+static int TakeTile(Ocean *ocean) {
+    if (ocean->freeCount > 0) return ocean->freeTiles[--ocean->freeCount];
+
+    int index = ocean->lruTail;
+    if (index < 0 || ocean->tiles[index].lastFrame == ocean->frame) return -1;
+    OceanTile *tile = &ocean->tiles[index];
+    UnlinkTile(ocean, index);
+    RemoveTile(ocean, index);
+    UnloadSprinkleBatch(&ocean->renderer, &tile->batch);
+    tile->loaded = false;
+    ocean->tilesEvicted++;
+    return index;
+}
+
+static void BuildTile(Ocean *ocean, int index, int x, int z) {
+    Vector3 positions[OCEAN_TILE_CAPACITY];
+    int count = GenerateTileSprinkles(ocean->seed, x, z, positions, OCEAN_TILE_CAPACITY);
+    for (int i = 0; i < count; i++) {
+        ocean->sprinkleX[index][i] = positions[i].x;
+        ocean->sprinkleZ[index][i] = positions[i].z;
+    }
+    ocean->sprinkleCounts[index] = count;
+
+    OceanTile *tile = &ocean->tiles[index];
+    tile->x = x;
+    tile->z = z;
+    tile->loaded = true;
+    // Tall enough for the sprinkles at the top and bottom of the waves
+    float bottom = OCEAN_SPRINKLE_Y - SPRINKLE_HEIGHT - WAVE_MAX_HEIGHT;
+    float top = OCEAN_SPRINKLE_Y + SPRINKLE_HEIGHT + WAVE_MAX_HEIGHT;
+    tile->bounds = (BoundingBox){
+        {x * OCEAN_TILE_SIZE - SPRINKLE_WIDTH, bottom, z * OCEAN_TILE_SIZE - SPRINKLE_WIDTH},
+        {(x + 1) * OCEAN_TILE_SIZE + SPRINKLE_WIDTH, top, (z + 1) * OCEAN_TILE_SIZE + SPRINKLE_WIDTH}
+    };
+    LoadSprinkleBatch(&ocean->renderer, &tile->batch, positions, count);
+    InsertTile(ocean, index);
+    PushTileFront(ocean, index);
+    ocean->tilesBuilt++;
+}
+
+void UpdateOcean(Ocean *ocean, Vector3 eye, float drawDistance) {
+    ocean->frame++;
+    int minX = (int)floorf((eye.x - drawDistance) / OCEAN_TILE_SIZE);
+    int maxX = (int)floorf((eye.x + drawDistance) / OCEAN_TILE_SIZE);
+    int minZ = (int)floorf((eye.z - drawDistance) / OCEAN_TILE_SIZE);
+    int maxZ = (int)floorf((eye.z + drawDistance) / OCEAN_TILE_SIZE);
+    int builds = 0;
+
+    for (int z = minZ; z <= maxZ; z++) {
+        for (int x = minX; x <= maxX; x++) {
+            // Only tiles whose square comes within drawDistance on the water plane
+            float dx = fmaxf(fmaxf(x * OCEAN_TILE_SIZE - eye.x, 0.0f), eye.x - (x + 1) * OCEAN_TILE_SIZE);
+            float dz = fmaxf(fmaxf(z * OCEAN_TILE_SIZE - eye.z, 0.0f), eye.z - (z + 1) * OCEAN_TILE_SIZE);
+            if (dx * dx + dz * dz > drawDistance * drawDistance) continue;
+
+            int index = FindTile(ocean, x, z);
+            if (index < 0) {
+                if (builds == OCEAN_BUILDS_PER_FRAME || (index = TakeTile(ocean)) < 0) continue;
+                BuildTile(ocean, index, x, z);
+                builds++;
+            } else {
+                UnlinkTile(ocean, index);
+                PushTileFront(ocean, index);
+            }
+            ocean->tiles[index].lastFrame = ocean->frame;
+        }
+    }
+}
+
+// Works out the wave heights of every visible tile, splitting them across the
+// helpers when there are enough sprinkles to be worth it
+static void BobSprinkles(Ocean *ocean, const WaveClock *clock, int visibleSprinkles) {
+    PROFILE_SCOPE(PHASE_FRAME_WAVES);
+    ocean->clock = *clock;
+    int tasks = visibleSprinkles / OCEAN_WAVE_TASK_SPRINKLES;
+    if (tasks > ocean->pool.threadCount + 1) tasks = ocean->pool.threadCount + 1;
+    if (tasks < 1) tasks = 1;
+    ocean->waveTasks = tasks;
+
+    for (int task = 1; task < tasks; task++) SubmitTask(&ocean->pool, task);
+    RunWaveTask(ocean, 0);
+    if (tasks > 1) WaitForWorkers(&ocean->pool);
+}
+
+void DrawOcean(Ocean *ocean, const Frustum *frustum, Vector3 eye, float drawDistance, float density, const WaveClock *clock,
+               Color color, CullStats *stats) {
+    // Tiles in range this frame sit at the front of the LRU list
+    int visibleSprinkles = 0;
+    ocean->visibleCount = 0;
+    for (int index = ocean->lruHead; index >= 0; index = ocean->tiles[index].next) {
+        const OceanTile *tile = &ocean->tiles[index];
+        if (tile->lastFrame != ocean->frame) break;
+        if (!IsBoxVisible(frustum, eye, drawDistance, tile->bounds)) {
+            stats->culledObjects += tile->batch.count;
+            continue;
+        }
+        int count = (int)(tile->batch.count * density + 0.5f);
+        ocean->drawCounts[index] = count;
+        ocean->visibleTiles[ocean->visibleCount++] = index;
+        visibleSprinkles += count;
+    }
+    stats->visibleObjects += visibleSprinkles;
+    BobSprinkles(ocean, clock, visibleSprinkles);
+
+    BeginSprinkles(&ocean->renderer, color);
+    for (int i = 0; i < ocean->visibleCount; i++) {
+        int index = ocean->visibleTiles[i];
+        UpdateSprinkleHeights(&ocean->renderer, &ocean->tiles[index].batch, ocean->heights[index], ocean->drawCounts[index]);
+        DrawSprinkleBatch(&ocean->renderer, &ocean->tiles[index].batch, ocean->drawCounts[index]);
+    }
+    EndSprinkles(&ocean->renderer);
+}
@@ -0,0 +1,79 @@
+#ifndef OCEAN_H
+#define OCEAN_H
+
+#include "sprinkles.h"
+#include "waves.h"
+#include "workers.h"
+#include <stdint.h>
+
+// Square tiles the ocean is streamed in; tile (x, z) covers [x, x + 1) * OCEAN_TILE_SIZE
+#define OCEAN_TILE_SIZE 50.0f
+// Average sprinkles per tile, the old 10000 over the 400x400 water
+#define OCEAN_TILE_SPRINKLES 156
+// Most sprinkles a tile can get, one and a half times the average, rounded up to
+// whole AVX vectors so the wave kernel never drops to scalar code for the last few
+#define OCEAN_TILE_CAPACITY ((OCEAN_TILE_SPRINKLES * 3 / 2 + 1 + 7) & ~7)
+#define OCEAN_SPRINKLE_Y -0.95f
+// Every client uses the same seed, so all of them see the same ocean
+#define OCEAN_SEED 0x0CEA5EEDu
+
+// Tiles kept uploaded; well above the ~50 within the default draw distance
+#define OCEAN_MAX_TILES 128
+#define OCEAN_TABLE_SIZE 256
+// Tiles generated per frame at most, so moving fast never stalls a frame
+#define OCEAN_BUILDS_PER_FRAME 8
+// Below this many visible sprinkles one thread bobs them all faster than waking the others
+#define OCEAN_WAVE_TASK_SPRINKLES 8192
+
+typedef struct {
+    int x, z;
+    bool loaded;
+    int prev, next;            // LRU list of loaded tiles, most recently used at the head
+    uint32_t lastFrame;        // last UpdateOcean that found it in range
+    BoundingBox bounds;
+    SprinkleBatch batch;
+} OceanTile;
+
+typedef struct {
+    SprinkleRenderer renderer;
+    uint32_t seed;
+    uint32_t frame;
+    OceanTile tiles[OCEAN_MAX_TILES];
+    int table[OCEAN_TABLE_SIZE];   // tile coordinate hash -> index in tiles, -1 when empty
+    int lruHead, lruTail;
+    int freeTiles[OCEAN_MAX_TILES];
+    int freeCount;
+    int tilesBuilt;                // running totals, for the stats overlay
+    int tilesEvicted;
+
+    // Where every loaded tile's sprinkles rest on the water plane, one row per tile,
+    // and the wave heights last worked out for them
+    int sprinkleCounts[OCEAN_MAX_TILES];
+    float sprinkleX[OCEAN_MAX_TILES][OCEAN_TILE_CAPACITY];
+    float sprinkleZ[OCEAN_MAX_TILES][OCEAN_TILE_CAPACITY];
+    float heights[OCEAN_MAX_TILES][OCEAN_TILE_CAPACITY];
+
+    // Helpers for frames with a lot of visible sprinkles, none on a single core
+    WorkerPool pool;
+    WaveClock clock;               // this frame's waves, shared with the helpers
+    int visibleTiles[OCEAN_MAX_TILES];
+    int visibleCount;
+    int drawCounts[OCEAN_MAX_TILES];   // leading sprinkles of each visible tile drawn this frame
+    int waveTasks;                 // visibleTiles is split into this many even runs
+} Ocean;
+
+void LoadOcean(Ocean *ocean, uint32_t seed);
+void UnloadOcean(Ocean *ocean);
+// Builds missing tiles within drawDistance of eye and marks them in use; once the
+// cache is full the least recently used tile out of range makes room
+void UpdateOcean(Ocean *ocean, Vector3 eye, float drawDistance);
+// Draws the tiles of the last UpdateOcean that pass the frustum and range test,
+// each sprinkle raised to the water height given by clock. density in (0, 1] thins
+// every tile evenly; a tile's sprinkles are in random order, so its first ones will do
+void DrawOcean(Ocean *ocean, const Frustum *frustum, Vector3 eye, float drawDistance, float density, const WaveClock *clock,
+               Color color, CullStats *stats);
+
+// Same seed and tile always give the same sprinkles; returns how many were written
+int GenerateTileSprinkles(uint32_t seed, int tileX, int tileZ, Vector3 *out, int capacity);
+
+#endif
@@ -0,0 +1,97 @@
+#include "profiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+PhaseHistory profilePhases[PHASE_COUNT];
+_Atomic uint64_t profileCounters[COUNTER_COUNT];
+_Thread_local uint64_t profileStarts[PHASE_COUNT];
+
+static const char *phaseNames[PHASE_COUNT] = {
+    "frame", "frame_input", "frame_world", "frame_cull", "frame_sprinkles", "frame_waves",
+    "frame_cannonballs", "frame_boats", "frame_hud", "tick", "tick_inputs", "tick_cannonballs", "tick_hits",
+    "tick_publish", "server_wait", "server_read", "server_send"
+};
+
+static const char *counterNames[COUNTER_COUNT] = {"bytes_sent", "bytes_received", "mutex_wait_ns", "tasks_stolen", "snapshots_skipped"};
+
+uint64_t ProfileNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void RecordPhase(ProfilePhase phase, uint64_t ns) {
+    PhaseHistory *history = &profilePhases[phase];
+    // Several workers can record the same phase at once; each claims its own slot.
+    // A reader may catch a claimed slot before its sample lands and see the one from a lap ago.
+    uint32_t head = atomic_fetch_add_explicit(&history->head, 1, memory_order_relaxed);
+    atomic_store_explicit(&history->samples[head % PROFILE_HISTORY], ns > UINT32_MAX ? UINT32_MAX : (uint32_t)ns,
+                          memory_order_relaxed);
+}
+
+void ResetPhaseHistories(void) {
+    for (int i = 0; i < PHASE_COUNT; i++) atomic_store_explicit(&profilePhases[i].head, 0, memory_order_relaxed);
+}
+
+void ProfileLock(pthread_mutex_t *mutex) {
+    if (pthread_mutex_trylock(mutex) == 0) return;
+    uint64_t start = ProfileNow();
+    pthread_mutex_lock(mutex);
+    atomic_fetch_add_explicit(&profileCounters[COUNTER_MUTEX_WAIT_NS], ProfileNow() - start, memory_order_relaxed);
+}
+
+const char *GetPhaseName(ProfilePhase phase) {
+    return phaseNames[phase];
+}
+
+const char *GetCounterName(ProfileCounter counter) {
+    return counterNames[counter];
+}
+
+// Copies out the buffered samples, oldest first; returns how many there are
+static int CopyPhaseSamples(ProfilePhase phase, uint32_t *samples) {
+    PhaseHistory *history = &profilePhases[phase];
+    uint32_t head = atomic_load_explicit(&history->head, memory_order_relaxed);
+    int count = head < PROFILE_HISTORY ? (int)head : PROFILE_HISTORY;
+    for (int i = 0; i < count; i++) {
+        samples[i] = atomic_load_explicit(&history->samples[(head - count + i) % PROFILE_HISTORY], memory_order_relaxed);
+    }
+    return count;
+}
+
+static int CompareSamples(const void *a, const void *b) {
+    uint32_t sa = *(const uint32_t *)a, sb = *(const uint32_t *)b;
+    return (sa > sb) - (sa < sb);
+}
+
+void GetPhaseStats(ProfilePhase phase, PhaseStats *stats) {
+    uint32_t samples[PROFILE_HISTORY];
+    *stats = (PhaseStats){.count = CopyPhaseSamples(phase, samples)};
+    if (stats->count == 0) return;
+
+    qsort(samples, stats->count, sizeof(uint32_t), CompareSamples);
+    double total = 0.0;
+    for (int i = 0; i < stats->count; i++) total += samples[i];
+    stats->minUs = samples[0] / 1000.0;
+    stats->meanUs = total / stats->count / 1000.0;
+    stats->p99Us = samples[(stats->count * 99) / 100] / 1000.0;
+    stats->maxUs = samples[stats->count - 1] / 1000.0;
+}
+
+bool ExportProfileCsv(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) return false;
+
+    fprintf(file, "name,sample,value\n");
+    uint32_t samples[PROFILE_HISTORY];
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        int count = CopyPhaseSamples(phase, samples);
+        for (int i = 0; i < count; i++) fprintf(file, "%s,%d,%.3f\n", phaseNames[phase], i, samples[i] / 1000.0);
+    }
+    for (int counter = 0; counter < COUNTER_COUNT; counter++) {
+        fprintf(file, "%s,0,%llu\n", counterNames[counter],
+                (unsigned long long)atomic_load_explicit(&profileCounters[counter], memory_order_relaxed));
+    }
+    return fclose(file) == 0;
+}
@@ -0,0 +1,97 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Build with -DPROFILING=0 to compile every PROFILE_* macro out
+#ifndef PROFILING
+#define PROFILING 1
+#endif
+
+// Samples kept per phase; statistics cover this many most recent ones
+#define PROFILE_HISTORY 256
+
+// Frames are timed on the render thread and server_wait/server_read on the server
+// thread. Ticks and server_send come from whichever thread steps a room, which is
+// every pool worker at once when the server hosts several rooms
+typedef enum {
+    PHASE_FRAME,               // whole frame, including waiting for vsync
+    PHASE_FRAME_INPUT,         // camera and local input
+    PHASE_FRAME_WORLD,         // snapshot or interpolation
+    PHASE_FRAME_CULL,
+    PHASE_FRAME_SPRINKLES,
+    PHASE_FRAME_WAVES,         // sprinkle wave heights, part of frame_sprinkles
+    PHASE_FRAME_CANNONBALLS,
+    PHASE_FRAME_BOATS,
+    PHASE_FRAME_HUD,
+    PHASE_TICK,                // whole simulation step
+    PHASE_TICK_INPUTS,
+    PHASE_TICK_CANNONBALLS,
+    PHASE_TICK_HITS,
+    PHASE_TICK_PUBLISH,
+    PHASE_SERVER_WAIT,         // blocked in epoll_wait
+    PHASE_SERVER_READ,         // draining sockets and handling packets
+    PHASE_SERVER_SEND,         // encoding and sending snapshots
+    PHASE_COUNT
+} ProfilePhase;
+
+typedef enum {
+    COUNTER_BYTES_SENT,
+    COUNTER_BYTES_RECEIVED,
+    COUNTER_MUTEX_WAIT_NS,
+    COUNTER_TASKS_STOLEN,      // worker pool tasks run by a thread other than the one they were queued on
+    COUNTER_SNAPSHOTS_SKIPPED, // snapshots not sent because the socket's send buffer was full
+    COUNTER_COUNT
+} ProfileCounter;
+
+// Ring of the latest samples of one phase, in nanoseconds
+typedef struct {
+    _Atomic uint32_t head;                         // total samples ever recorded
+    _Atomic uint32_t samples[PROFILE_HISTORY];
+} PhaseHistory;
+
+typedef struct {
+    int count;
+    double minUs, meanUs, p99Us, maxUs;
+} PhaseStats;
+
+extern PhaseHistory profilePhases[PHASE_COUNT];
+extern _Atomic uint64_t profileCounters[COUNTER_COUNT];
+extern _Thread_local uint64_t profileStarts[PHASE_COUNT];
+
+uint64_t ProfileNow(void);
+void RecordPhase(ProfilePhase phase, uint64_t ns);
+// Forgets every buffered phase sample; counters keep running. Only while nothing else records.
+void ResetPhaseHistories(void);
+// Takes the mutex and adds the time spent waiting for it to COUNTER_MUTEX_WAIT_NS
+void ProfileLock(pthread_mutex_t *mutex);
+
+const char *GetPhaseName(ProfilePhase phase);
+const char *GetCounterName(ProfileCounter counter);
+void GetPhaseStats(ProfilePhase phase, PhaseStats *stats);
+// Writes name,sample,value rows: every buffered phase sample in microseconds,
+// then one row per counter with its running total
+bool ExportProfileCsv(const char *path);
+
+#if PROFILING
+#define PROFILE_BEGIN(phase) (profileStarts[phase] = ProfileNow())
+#define PROFILE_END(phase) RecordPhase(phase, ProfileNow() - profileStarts[phase])
+// Ends the phase when the enclosing block exits
+#define PROFILE_SCOPE(phase) \
+    __attribute__((cleanup(EndProfileScope))) ProfilePhase profileScope_##phase = (PROFILE_BEGIN(phase), phase)
+#define PROFILE_COUNT(counter, amount) \
+    atomic_fetch_add_explicit(&profileCounters[counter], (uint64_t)(amount), memory_order_relaxed)
+#define PROFILE_LOCK(mutex) ProfileLock(mutex)
+static inline void EndProfileScope(ProfilePhase *phase) { PROFILE_END(*phase); }
+#else
+#define PROFILE_BEGIN(phase) ((void)0)
+#define PROFILE_END(phase) ((void)0)
+#define PROFILE_SCOPE(phase) ((void)0)
+#define PROFILE_COUNT(counter, amount) ((void)0)
+#define PROFILE_LOCK(mutex) pthread_mutex_lock(mutex)
+#endif
+
+#endif
@@ -0,0 +1,455 @@
+#include "protocol.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Delta record flags: which fields follow the kind/id/flags prefix
+#define DELTA_X 0x01
+#define DELTA_Y 0x02
+#define DELTA_Z 0x04
+#define DELTA_VALUE 0x08
+#define DELTA_DIRECTION 0x10
+#define DELTA_START_TICK 0x20
+#define DELTA_NEW 0x40             // entity is not in the baseline, every field follows
+#define DELTA_REMOVED 0x80         // entity left the snapshot, nothing follows
+#define DELTA_ALL_FIELDS 0x3F
+
+// Largest record: kind, id, flags, value, position, direction, start tick
+#define DELTA_MAX_RECORD_SIZE (1 + 2 + 1 + 2 + 6 + 6 + 4)
+
+void InitByteWriter(ByteWriter *writer, uint8_t *buffer, int capacity) {
+    writer->data = buffer;
+    writer->capacity = capacity;
+    writer->size = 0;
+    writer->overflow = false;
+}
+
+static bool Reserve(ByteWriter *writer, int bytes) {
+    if (writer->overflow || writer->size + bytes > writer->capacity) {
+        writer->overflow = true;
+        return false;
+    }
+    return true;
+}
+
+void WriteU8(ByteWriter *writer, uint8_t value) {
+    if (!Reserve(writer, 1)) return;
+    writer->data[writer->size++] = value;
+}
+
+void WriteU16(ByteWriter *writer, uint16_t value) {
+    if (!Reserve(writer, 2)) return;
+    writer->data[writer->size++] = (uint8_t)value;
+    writer->data[writer->size++] = (uint8_t)(value >> 8);
+}
+
+void WriteU32(ByteWriter *writer, uint32_t value) {
+    if (!Reserve(writer, 4)) return;
+    for (int i = 0; i < 4; i++) writer->data[writer->size++] = (uint8_t)(value >> (8 * i));
+}
+
+void WriteI16(ByteWriter *writer, int16_t value) {
+    WriteU16(writer, (uint16_t)value);
+}
+
+void WriteBytes(ByteWriter *writer, const uint8_t *bytes, int count) {
+    if (!Reserve(writer, count)) return;
+    memcpy(writer->data + writer->size, bytes, count);
+    writer->size += count;
+}
+
+void InitByteReader(ByteReader *reader, const uint8_t *data, int size) {
+    reader->data = data;
+    reader->size = size;
+    reader->offset = 0;
+    reader->error = false;
+}
+
+static bool Available(ByteReader *reader, int bytes) {
+    if (reader->error || reader->offset + bytes > reader->size) {
+        reader->error = true;
+        return false;
+    }
+    return true;
+}
+
+uint8_t ReadU8(ByteReader *reader) {
+    if (!Available(reader, 1)) return 0;
+    return reader->data[reader->offset++];
+}
+
+uint16_t ReadU16(ByteReader *reader) {
+    if (!Available(reader, 2)) return 0;
+    uint16_t value = (uint16_t)(reader->data[reader->offset] | (reader->data[reader->offset + 1] << 8));
+    reader->offset += 2;
+    return value;
+}
+
+uint32_t ReadU32(ByteReader *reader) {
+    if (!Available(reader, 4)) return 0;
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) value |= (uint32_t)reader->data[reader->offset++] << (8 * i);
+    return value;
+}
+
+int16_t ReadI16(ByteReader *reader) {
+    return (int16_t)ReadU16(reader);
+}
+
+void BeginPacket(ByteWriter *writer, uint8_t *buffer, int capacity, PacketType type, uint32_t tick) {
+    InitByteWriter(writer, buffer, capacity);
+    WriteU16(writer, PROTOCOL_MAGIC);
+    WriteU8(writer, PROTOCOL_VERSION);
+    WriteU8(writer, (uint8_t)type);
+    WriteU32(writer, tick);
+    WriteU16(writer, 0);
+}
+
+int EndPacket(ByteWriter *writer) {
+    if (writer->overflow) return -1;
+    int length = writer->size - PACKET_HEADER_SIZE;
+    writer->data[8] = (uint8_t)length;
+    writer->data[9] = (uint8_t)(length >> 8);
+    return writer->size;
+}
+
+bool ReadPacketHeader(ByteReader *reader, PacketHeader *header) {
+    header->magic = ReadU16(reader);
+    header->version = ReadU8(reader);
+    header->type = ReadU8(reader);
+    header->tick = ReadU32(reader);
+    header->length = ReadU16(reader);
+    if (reader->error || header->magic != PROTOCOL_MAGIC || header->version != PROTOCOL_VERSION) return false;
+    return reader->offset + header->length <= reader->size;
+}
+
+static int16_t QuantizeClamped(float value) {
+    float q = roundf(value);
+    if (q > 32767.0f) q = 32767.0f;
+    if (q < -32768.0f) q = -32768.0f;
+    return (int16_t)q;
+}
+
+int16_t QuantizePosition(float value) {
+    return QuantizeClamped(value * NET_POSITION_SCALE);
+}
+
+float DequantizePosition(int16_t value) {
+    return value / NET_POSITION_SCALE;
+}
+
+int16_t QuantizeDirection(float value) {
+    return QuantizeClamped(value * NET_DIRECTION_SCALE);
+}
+
+float DequantizeDirection(int16_t value) {
+    return value / NET_DIRECTION_SCALE;
+}
+
+void WriteInput(ByteWriter *writer, const PlayerInput *input, uint32_t ackTick) {
+    WriteU32(writer, ackTick);
+    WriteI16(writer, QuantizePosition(input->position.x));
+    WriteI16(writer, QuantizePosition(input->position.y));
+    WriteI16(writer, QuantizePosition(input->position.z));
+    WriteI16(writer, QuantizeDirection(input->aim.x));
+    WriteI16(writer, QuantizeDirection(input->aim.y));
+    WriteI16(writer, QuantizeDirection(input->aim.z));
+    WriteU32(writer, input->shots);
+}
+
+bool ReadInput(ByteReader *reader, PlayerInput *input, uint32_t *ackTick) {
+    *ackTick = ReadU32(reader);
+    input->connected = true;
+    input->position.x = DequantizePosition(ReadI16(reader));
+    input->position.y = DequantizePosition(ReadI16(reader));
+    input->position.z = DequantizePosition(ReadI16(reader));
+    input->aim.x = DequantizeDirection(ReadI16(reader));
+    input->aim.y = DequantizeDirection(ReadI16(reader));
+    input->aim.z = DequantizeDirection(ReadI16(reader));
+    input->shots = ReadU32(reader);
+    return !reader->error;
+}
+
+int BuildPingPacket(uint8_t *buffer, int capacity, PacketType type, uint32_t sequence, uint32_t timeUs) {
+    ByteWriter writer;
+    BeginPacket(&writer, buffer, capacity, type, sequence);
+    WriteU32(&writer, timeUs);
+    return EndPacket(&writer);
+}
+
+void InitNetSnapshot(NetSnapshot *snapshot) {
+    memset(snapshot, 0, sizeof(*snapshot));
+}
+
+void FreeNetSnapshot(NetSnapshot *snapshot) {
+    free(snapshot->entities);
+    memset(snapshot, 0, sizeof(*snapshot));
+}
+
+static void ReserveEntities(NetSnapshot *snapshot, int count) {
+    if (count <= snapshot->capacity) return;
+    int capacity = snapshot->capacity ? snapshot->capacity : 64;
+    while (capacity < count) capacity *= 2;
+    snapshot->entities = realloc(snapshot->entities, capacity * sizeof(NetEntity));
+    snapshot->capacity = capacity;
+}
+
+static void PushEntity(NetSnapshot *snapshot, const NetEntity *entity) {
+    ReserveEntities(snapshot, snapshot->count + 1);
+    snapshot->entities[snapshot->count++] = *entity;
+}
+
+void CopyNetSnapshot(NetSnapshot *dst, const NetSnapshot *src) {
+    ReserveEntities(dst, src->count);
+    if (src->count > 0) memcpy(dst->entities, src->entities, src->count * sizeof(NetEntity));
+    dst->count = src->count;
+    dst->tick = src->tick;
+}
+
+void FilterNetSnapshot(const NetSnapshot *src, const int *indices, int count, NetSnapshot *out) {
+    ReserveEntities(out, count);
+    for (int i = 0; i < count; i++) out->entities[i] = src->entities[indices[i]];
+    out->count = count;
+    out->tick = src->tick;
+}
+
+static int CompareEntityIds(const void *a, const void *b) {
+    return (int)((const NetEntity *)a)->id - (int)((const NetEntity *)b)->id;
+}
+
+void CaptureNetSnapshot(const WorldSnapshot *world, NetSnapshot *out) {
+    out->tick = world->tick;
+    out->count = 0;
+
+    for (int i = 0; i < world->playerCount; i++) {
+        const Player *player = &world->players[i];
+        if (!player->active) continue;
+        NetEntity boat = {
+            .kind = ENTITY_BOAT,
+            .id = (uint16_t)i,
+            .value = (uint16_t)player->health,
+            .position = {QuantizePosition(player->position.x), QuantizePosition(player->position.y), QuantizePosition(player->position.z)}
+        };
+        PushEntity(out, &boat);
+    }
+
+    // Pool order is arbitrary; records must be sorted by id
+    const ProjectilePool *pool = &world->projectiles;
+    int firstBall = out->count;
+    for (int i = 0; i < pool->count; i++) {
+        NetEntity entity = {
+            .kind = ENTITY_CANNONBALL,
+            .id = (uint16_t)pool->id[i],
+            .value = (uint16_t)pool->owner[i],
+            .position = {QuantizePosition(pool->origin[i].x), QuantizePosition(pool->origin[i].y), QuantizePosition(pool->origin[i].z)},
+            .direction = {QuantizeDirection(pool->direction[i].x), QuantizeDirection(pool->direction[i].y), QuantizeDirection(pool->direction[i].z)},
+            .startTick = pool->launchTick[i]
+        };
+        PushEntity(out, &entity);
+    }
+    qsort(out->entities + firstBall, out->count - firstBall, sizeof(NetEntity), CompareEntityIds);
+}
+
+Vec3 GetNetCannonballPosition(const NetEntity *entity, double tick, int tickRate) {
+    float distance = (float)((tick - entity->startTick) / tickRate) * CANNONBALL_SPEED;
+    return (Vec3){
+        DequantizePosition(entity->position[0]) + DequantizeDirection(entity->direction[0]) * distance,
+        DequantizePosition(entity->position[1]) + DequantizeDirection(entity->direction[1]) * distance,
+        DequantizePosition(entity->position[2]) + DequantizeDirection(entity->direction[2]) * distance
+    };
+}
+
+static int CompareEntityKeys(const NetEntity *a, const NetEntity *b) {
+    uint32_t ka = ((uint32_t)a->kind << 16) | a->id;
+    uint32_t kb = ((uint32_t)b->kind << 16) | b->id;
+    return (ka > kb) - (ka < kb);
+}
+
+static uint8_t ChangedFields(const NetEntity *from, const NetEntity *to) {
+    uint8_t flags = 0;
+    if (from->position[0] != to->position[0]) flags |= DELTA_X;
+    if (from->position[1] != to->position[1]) flags |= DELTA_Y;
+    if (from->position[2] != to->position[2]) flags |= DELTA_Z;
+    if (from->value != to->value) flags |= DELTA_VALUE;
+    if (memcmp(from->direction, to->direction, sizeof(from->direction)) != 0) flags |= DELTA_DIRECTION;
+    if (from->startTick != to->startTick) flags |= DELTA_START_TICK;
+    return flags;
+}
+
+static void WriteRecord(ByteWriter *writer, const NetEntity *entity, uint8_t flags) {
+    WriteU8(writer, entity->kind);
+    WriteU16(writer, entity->id);
+    WriteU8(writer, flags);
+    if (flags & DELTA_REMOVED) return;
+    if (flags & DELTA_VALUE) WriteU16(writer, entity->value);
+    if (flags & DELTA_X) WriteI16(writer, entity->position[0]);
+    if (flags & DELTA_Y) WriteI16(writer, entity->position[1]);
+    if (flags & DELTA_Z) WriteI16(writer, entity->position[2]);
+    if (flags & DELTA_DIRECTION) {
+        for (int i = 0; i < 3; i++) WriteI16(writer, entity->direction[i]);
+    }
+    if (flags & DELTA_START_TICK) WriteU32(writer, entity->startTick);
+}
+
+// `shared` is optional; with it, indices map current's entities into the shared records
+static void WriteDelta(ByteWriter *writer, const NetSnapshot *baseline, const NetSnapshot *current,
+                       const int *indices, const SharedRecords *shared, NetSnapshot *sent) {
+    static const NetSnapshot empty = { 0 };
+    if (!baseline) baseline = &empty;
+
+    sent->tick = current->tick;
+    sent->count = 0;
+
+    int countOffset = writer->size;
+    WriteU16(writer, 0);
+    int records = 0;
+
+    // Merge walk over both sorted lists. Once the packet is full the rest of the
+    // baseline is carried over untouched, so `sent` stays what the receiver has.
+    int b = 0, c = 0;
+    while (b < baseline->count || c < current->count) {
+        const NetEntity *from = (b < baseline->count) ? &baseline->entities[b] : NULL;
+        const NetEntity *to = (c < current->count) ? &current->entities[c] : NULL;
+        int order = (!from) ? 1 : (!to) ? -1 : CompareEntityKeys(from, to);
+        bool room = writer->size + DELTA_MAX_RECORD_SIZE <= writer->capacity && records < UINT16_MAX;
+
+        if (order < 0) {
+            // In the baseline only: despawn
+            if (room) {
+                WriteRecord(writer, from, DELTA_REMOVED);
+                records++;
+            } else {
+                PushEntity(sent, from);
+            }
+            b++;
+        } else if (order > 0) {
+            // In the current snapshot only: spawn with every field
+            if (room) {
+                if (shared) {
+                    const SharedEntity *cached = &shared->entities[indices[c]];
+                    WriteBytes(writer, shared->data + cached->spawnOffset, cached->spawnSize);
+                } else {
+                    WriteRecord(writer, to, DELTA_NEW | DELTA_ALL_FIELDS);
+                }
+                records++;
+                PushEntity(sent, to);
+            }
+            c++;
+        } else {
+            // The shared change record fits whenever the receiver has what everyone had last tick
+            const SharedEntity *cached = shared ? &shared->entities[indices[c]] : NULL;
+            bool reuse = cached && cached->hasPrevious && ChangedFields(from, &cached->previous) == 0;
+            uint8_t flags = reuse ? 0 : ChangedFields(from, to);
+            bool changed = reuse ? cached->changeSize > 0 : flags != 0;
+            if (changed && room) {
+                if (reuse) {
+                    WriteBytes(writer, shared->data + cached->changeOffset, cached->changeSize);
+                } else {
+                    WriteRecord(writer, to, flags);
+                }
+                records++;
+                PushEntity(sent, to);
+            } else {
+                PushEntity(sent, from);
+            }
+            b++;
+            c++;
+        }
+    }
+
+    if (!writer->overflow) {
+        writer->data[countOffset] = (uint8_t)records;
+        writer->data[countOffset + 1] = (uint8_t)(records >> 8);
+    }
+}
+
+void WriteSnapshotDelta(ByteWriter *writer, const NetSnapshot *baseline, const NetSnapshot *current, NetSnapshot *sent) {
+    WriteDelta(writer, baseline, current, NULL, NULL, sent);
+}
+
+void WriteSharedSnapshotDelta(ByteWriter *writer, const NetSnapshot *baseline, const NetSnapshot *current,
+                              const int *indices, const SharedRecords *shared, NetSnapshot *sent) {
+    WriteDelta(writer, baseline, current, indices, shared, sent);
+}
+
+bool ReadSnapshotDelta(ByteReader *reader, const NetSnapshot *baseline, NetSnapshot *out) {
+    static const NetSnapshot empty = { 0 };
+    if (!baseline) baseline = &empty;
+
+    out->count = 0;
+    int records = ReadU16(reader);
+    int b = 0;
+
+    // Records arrive in key order, so this is the same merge walk as the writer
+    for (int r = 0; r < records && !reader->error; r++) {
+        NetEntity record = { 0 };
+        record.kind = ReadU8(reader);
+        record.id = ReadU16(reader);
+        uint8_t flags = ReadU8(reader);
+
+        while (b < baseline->count && CompareEntityKeys(&baseline->entities[b], &record) < 0) {
+            PushEntity(out, &baseline->entities[b++]);
+        }
+        bool inBaseline = b < baseline->count && CompareEntityKeys(&baseline->entities[b], &record) == 0;
+        if (inBaseline) record = baseline->entities[b++];
+        if (flags & DELTA_REMOVED) continue;
+        if (!inBaseline && !(flags & DELTA_NEW)) return false;
+
+        if (flags & DELTA_VALUE) record.value = ReadU16(reader);
+        if (flags & DELTA_X) record.position[0] = ReadI16(reader);
+        if (flags & DELTA_Y) record.position[1] = ReadI16(reader);
+        if (flags & DELTA_Z) record.position[2] = ReadI16(reader);
+        if (flags & DELTA_DIRECTION) {
+            for (int i = 0; i < 3; i++) record.direction[i] = ReadI16(reader);
+        }
+        if (flags & DELTA_START_TICK) record.startTick = ReadU32(reader);
+        PushEntity(out, &record);
+    }
+    while (b < baseline->count) PushEntity(out, &baseline->entities[b++]);
+
+    return !reader->error;
+}
+
+void InitSharedRecords(SharedRecords *shared) {
+    memset(shared, 0, sizeof(*shared));
+}
+
+void FreeSharedRecords(SharedRecords *shared) {
+    FreeNetSnapshot(&shared->previous);
+    free(shared->entities);
+    free(shared->data);
+    memset(shared, 0, sizeof(*shared));
+}
+
+void EncodeSharedRecords(SharedRecords *shared, const NetSnapshot *current) {
+    if (current->count > shared->entityCapacity) {
+        shared->entityCapacity = current->count * 2;
+        shared->entities = realloc(shared->entities, shared->entityCapacity * sizeof(SharedEntity));
+        shared->capacity = shared->entityCapacity * 2 * DELTA_MAX_RECORD_SIZE;
+        shared->data = realloc(shared->data, shared->capacity);
+    }
+
+    ByteWriter writer;
+    InitByteWriter(&writer, shared->data, shared->capacity);
+    const NetSnapshot *previous = &shared->previous;
+    int p = 0;
+    for (int c = 0; c < current->count; c++) {
+        const NetEntity *entity = &current->entities[c];
+        SharedEntity *cached = &shared->entities[c];
+        while (p < previous->count && CompareEntityKeys(&previous->entities[p], entity) < 0) p++;
+        cached->hasPrevious = p < previous->count && CompareEntityKeys(&previous->entities[p], entity) == 0;
+
+        cached->spawnOffset = writer.size;
+        WriteRecord(&writer, entity, DELTA_NEW | DELTA_ALL_FIELDS);
+        cached->spawnSize = (uint8_t)(writer.size - cached->spawnOffset);
+        cached->changeOffset = writer.size;
+        if (cached->hasPrevious) {
+            cached->previous = previous->entities[p];
+            uint8_t flags = ChangedFields(&cached->previous, entity);
+            if (flags) WriteRecord(&writer, entity, flags);
+        }
+        cached->changeSize = (uint8_t)(writer.size - cached->changeOffset);
+    }
+    shared->size = writer.size;
+    CopyNetSnapshot(&shared->previous, current);
+}
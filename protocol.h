@@ -0,0 +1,158 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include "sim.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PROTOCOL_MAGIC 0x4642      // "FB"
+#define PROTOCOL_VERSION 2
+#define PACKET_HEADER_SIZE 10
+#define PACKET_MAX_SIZE 1200       // stays under a typical path MTU
+
+// Positions travel as 1/64 unit steps, good for +-512 units, so WORLD_HALF_EXTENT fits
+#define NET_POSITION_SCALE 64.0f
+#define NET_DIRECTION_SCALE 32767.0f
+
+// Cannonball entity ids are projectile pool ids, which must fit in 16 bits
+#define NET_MAX_PLAYERS (65536 / MAX_CANNONBALLS)
+
+// Sent snapshots kept per peer as delta baselines, indexed by tick
+#define NET_SNAPSHOT_HISTORY 32
+
+typedef enum {
+    PACKET_HELLO = 1,      // client -> server: asks for a player slot
+    PACKET_WELCOME,        // server -> client: assigned player id, tick rate and player capacity
+    PACKET_INPUT,          // client -> server: latest input plus snapshot ack
+    PACKET_SNAPSHOT,       // server -> client: tick timing and a world delta against an acked baseline
+    PACKET_BYE,            // either way: connection is going away
+    PACKET_PING,           // either way: sender's clock in microseconds, tick is the ping's sequence
+    PACKET_PONG            // either way: a PING sent straight back
+} PacketType;
+
+// Every packet starts with this, little-endian on the wire
+typedef struct {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t type;
+    uint32_t tick;         // snapshot tick, or the input sequence for PACKET_INPUT
+    uint16_t length;       // payload bytes after the header
+} PacketHeader;
+
+typedef enum {
+    ENTITY_BOAT = 0,
+    ENTITY_CANNONBALL
+} EntityKind;
+
+// Quantized state of one boat or cannonball as the receiver sees it.
+// Cannonballs fly in a straight line, so they carry their launch point and
+// tick and never change after spawning.
+typedef struct {
+    uint8_t kind;
+    uint16_t id;               // boats: player id; cannonballs: projectile id
+    uint16_t value;            // boats: health; cannonballs: owner id
+    int16_t position[3];       // boats: current position; cannonballs: launch point
+    int16_t direction[3];      // cannonballs only
+    uint32_t startTick;        // cannonballs only
+} NetEntity;
+
+typedef struct {
+    uint32_t tick;
+    int count;
+    int capacity;
+    NetEntity *entities;       // sorted by kind, then id
+} NetSnapshot;
+
+// Where one entity's records sit in SharedRecords.data
+typedef struct {
+    int spawnOffset;
+    int changeOffset;
+    uint8_t spawnSize;
+    uint8_t changeSize;        // 0 when nothing changed since the previous tick
+    bool hasPrevious;          // also in the previous tick, as `previous`
+    NetEntity previous;
+} SharedEntity;
+
+// One tick's records, encoded once for every peer: each entity as a spawn and
+// as its change since the previous tick. Any peer whose baseline holds an
+// entity as it was last tick gets these bytes instead of encoding its own.
+typedef struct {
+    NetSnapshot previous;      // the full snapshot of the previous tick
+    SharedEntity *entities;    // by index in the current full snapshot
+    int entityCapacity;
+    uint8_t *data;
+    int size;
+    int capacity;
+} SharedRecords;
+
+typedef struct {
+    uint8_t *data;
+    int capacity;
+    int size;
+    bool overflow;
+} ByteWriter;
+
+typedef struct {
+    const uint8_t *data;
+    int size;
+    int offset;
+    bool error;
+} ByteReader;
+
+void InitByteWriter(ByteWriter *writer, uint8_t *buffer, int capacity);
+void WriteU8(ByteWriter *writer, uint8_t value);
+void WriteU16(ByteWriter *writer, uint16_t value);
+void WriteU32(ByteWriter *writer, uint32_t value);
+void WriteI16(ByteWriter *writer, int16_t value);
+void WriteBytes(ByteWriter *writer, const uint8_t *bytes, int count);
+
+void InitByteReader(ByteReader *reader, const uint8_t *data, int size);
+uint8_t ReadU8(ByteReader *reader);
+uint16_t ReadU16(ByteReader *reader);
+uint32_t ReadU32(ByteReader *reader);
+int16_t ReadI16(ByteReader *reader);
+
+// Writes a header with a zero length; EndPacket patches it and returns the packet size, or -1 on overflow
+void BeginPacket(ByteWriter *writer, uint8_t *buffer, int capacity, PacketType type, uint32_t tick);
+int EndPacket(ByteWriter *writer);
+// Validates magic, version and length; leaves the reader at the payload
+bool ReadPacketHeader(ByteReader *reader, PacketHeader *header);
+
+int16_t QuantizePosition(float value);
+float DequantizePosition(int16_t value);
+int16_t QuantizeDirection(float value);
+float DequantizeDirection(int16_t value);
+
+void WriteInput(ByteWriter *writer, const PlayerInput *input, uint32_t ackTick);
+bool ReadInput(ByteReader *reader, PlayerInput *input, uint32_t *ackTick);
+// PING or PONG; returns the packet size
+int BuildPingPacket(uint8_t *buffer, int capacity, PacketType type, uint32_t sequence, uint32_t timeUs);
+
+void InitNetSnapshot(NetSnapshot *snapshot);
+void FreeNetSnapshot(NetSnapshot *snapshot);
+void CopyNetSnapshot(NetSnapshot *dst, const NetSnapshot *src);
+// Copies the entities at `indices`, which must be ascending so the result stays sorted
+void FilterNetSnapshot(const NetSnapshot *src, const int *indices, int count, NetSnapshot *out);
+// Quantizes every active boat and cannonball of the world
+void CaptureNetSnapshot(const WorldSnapshot *world, NetSnapshot *out);
+// Position of a cannonball entity at `tick`, which may fall between ticks
+Vec3 GetNetCannonballPosition(const NetEntity *entity, double tick, int tickRate);
+
+// Writes the records that turn `baseline` (NULL for a full snapshot) into `current`,
+// as many as fit. `sent` receives exactly what the receiver holds after decoding them.
+// With per-client filtered snapshots the new and removed records are the explicit
+// spawn and despawn of entities entering and leaving that client's area of interest.
+void WriteSnapshotDelta(ByteWriter *writer, const NetSnapshot *baseline, const NetSnapshot *current, NetSnapshot *sent);
+bool ReadSnapshotDelta(ByteReader *reader, const NetSnapshot *baseline, NetSnapshot *out);
+
+void InitSharedRecords(SharedRecords *shared);
+void FreeSharedRecords(SharedRecords *shared);
+// Encodes every entity of the full snapshot, once per tick before the first peer is written
+void EncodeSharedRecords(SharedRecords *shared, const NetSnapshot *current);
+// WriteSnapshotDelta for a filtered view of the full snapshot last given to
+// EncodeSharedRecords: current->entities[i] is entity indices[i] of that snapshot.
+// Writes the same bytes, copying shared records wherever they apply.
+void WriteSharedSnapshotDelta(ByteWriter *writer, const NetSnapshot *baseline, const NetSnapshot *current,
+                              const int *indices, const SharedRecords *shared, NetSnapshot *sent);
+
+#endif
@@ -0,0 +1,73 @@
+#include "quality.h"
+#include <string.h>
+
+// Full detail is what the game drew before there was a governor
+static const QualitySettings levels[QUALITY_LEVELS] = {
+    {"lowest", 0.2f, 0.4f, 4, 6},
+    {"low", 0.35f, 0.55f, 6, 8},
+    {"medium", 0.5f, 0.7f, 8, 10},
+    {"high", 0.75f, 0.85f, 12, 12},
+    {"full", 1.0f, 1.0f, 16, 16}
+};
+
+void InitQualityGovernor(QualityGovernor *governor, float budgetMs, int level) {
+    memset(governor, 0, sizeof(*governor));
+    governor->budgetMs = budgetMs;
+    governor->raiseHold = QUALITY_RAISE_HOLD;
+    governor->level = level < 0 ? 0 : level >= QUALITY_LEVELS ? QUALITY_LEVELS - 1 : level;
+}
+
+// Starts a fresh window so frames drawn at the old level don't count against the new one
+static void ChangeLevel(QualityGovernor *governor, int level) {
+    bool raised = level > governor->level;
+    if (!raised) {
+        // Dropping right after a raise means the level above doesn't fit yet
+        bool reverted = governor->lastChangeRaised && governor->framesSinceChange < QUALITY_RAISE_HOLD;
+        governor->raiseHold = reverted ? governor->raiseHold * 2 : QUALITY_RAISE_HOLD;
+        if (governor->raiseHold > QUALITY_MAX_RAISE_HOLD) governor->raiseHold = QUALITY_MAX_RAISE_HOLD;
+    }
+    governor->lastChangeRaised = raised;
+    governor->level = level;
+    governor->framesSinceChange = 0;
+    governor->count = 0;
+    governor->changes++;
+}
+
+bool UpdateQualityGovernor(QualityGovernor *governor, float frameMs, float workMs) {
+    float maxMs = governor->budgetMs * QUALITY_MAX_SAMPLE_RATIO;
+    if (frameMs > maxMs) frameMs = maxMs;
+    if (workMs > maxMs) workMs = maxMs;
+    governor->frameMs[governor->head] = frameMs;
+    governor->workMs[governor->head] = workMs;
+    governor->head = (governor->head + 1) % QUALITY_WINDOW;
+    if (governor->count < QUALITY_WINDOW) governor->count++;
+    governor->framesSinceChange++;
+    if (governor->count < QUALITY_WINDOW) return false;
+
+    float frameSum = 0.0f, workSum = 0.0f, frameMax = 0.0f;
+    for (int i = 0; i < QUALITY_WINDOW; i++) {
+        frameSum += governor->frameMs[i];
+        workSum += governor->workMs[i];
+        if (governor->frameMs[i] > frameMax) frameMax = governor->frameMs[i];
+    }
+    float frameMean = frameSum / QUALITY_WINDOW, workMean = workSum / QUALITY_WINDOW;
+
+    if (governor->level > 0 && governor->framesSinceChange >= QUALITY_DROP_HOLD &&
+        frameMean > governor->budgetMs * QUALITY_DROP_RATIO) {
+        ChangeLevel(governor, governor->level - 1);
+        return true;
+    }
+    // Spikes that average out still mean this level is only just holding
+    if (governor->level < QUALITY_LEVELS - 1 && governor->framesSinceChange >= governor->raiseHold &&
+        frameMax <= governor->budgetMs * QUALITY_DROP_RATIO && workMean < governor->budgetMs * QUALITY_RAISE_RATIO) {
+        ChangeLevel(governor, governor->level + 1);
+        return true;
+    }
+    return false;
+}
+
+const QualitySettings *GetQualitySettings(int level) {
+    if (level < 0) level = 0;
+    if (level >= QUALITY_LEVELS) level = QUALITY_LEVELS - 1;
+    return &levels[level];
+}
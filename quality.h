@@ -0,0 +1,54 @@
+#ifndef QUALITY_H
+#define QUALITY_H
+
+#include <stdbool.h>
+
+// Detail levels, 0 is the cheapest and QUALITY_LEVELS - 1 full detail
+#define QUALITY_LEVELS 5
+// Frames averaged before deciding anything, half a second at 60 fps
+#define QUALITY_WINDOW 30
+// Drop a level once the average frame runs this far past the budget
+#define QUALITY_DROP_RATIO 1.05f
+// Raise a level only when the average frame's own work fits in this share of the budget
+// and no frame of the window ran past the drop threshold.
+// The gap between the two is the hysteresis: a level that just fits doesn't flip back
+#define QUALITY_RAISE_RATIO 0.6f
+// A single hitch counts as at most this many budgets, so one long frame alone can't drop a level
+#define QUALITY_MAX_SAMPLE_RATIO 2.0f
+// Frames to wait after a change before dropping again and before raising again; raising
+// waits longer so a level that was just too slow isn't retried straight away
+#define QUALITY_DROP_HOLD QUALITY_WINDOW
+#define QUALITY_RAISE_HOLD (QUALITY_WINDOW * 8)
+// Each raise that has to be taken back doubles the wait before the next one, up to this
+#define QUALITY_MAX_RAISE_HOLD (QUALITY_RAISE_HOLD * 16)
+
+// What a level draws
+typedef struct {
+    const char *name;
+    float sprinkleDensity;     // share of each ocean tile's sprinkles drawn
+    float drawDistanceScale;   // times CULL_DEFAULT_DRAW_DISTANCE
+    int sphereRings;           // cannonball tessellation
+    int sphereSlices;
+} QualitySettings;
+
+// Moves one level at a time to keep frames within budgetMs
+typedef struct {
+    float budgetMs;
+    int level;
+    int framesSinceChange;
+    bool lastChangeRaised;
+    int raiseHold;                     // frames the next raise waits for
+    float frameMs[QUALITY_WINDOW];     // ring of the latest frames, including any wait for vsync
+    float workMs[QUALITY_WINDOW];      // the same frames up to handing them to the driver
+    int head;
+    int count;
+    int changes;                       // running total, for the stats overlay
+} QualityGovernor;
+
+void InitQualityGovernor(QualityGovernor *governor, float budgetMs, int level);
+// Adds one frame; returns true when it moved the level. With a frame rate target the
+// whole frame never drops below the budget, which is why the work is passed separately
+bool UpdateQualityGovernor(QualityGovernor *governor, float frameMs, float workMs);
+const QualitySettings *GetQualitySettings(int level);
+
+#endif
@@ -0,0 +1,196 @@
+#include "record.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define RECORD_INPUT_SIZE (2 + 1 + 6 * 4 + 4)
+
+// Full bit pattern, so a replay feeds the simulation exactly what it saw
+static void WriteF32(ByteWriter *writer, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    WriteU32(writer, bits);
+}
+
+static float ReadF32(ByteReader *reader) {
+    uint32_t bits = ReadU32(reader);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void BeginEntry(ByteWriter *writer, uint8_t *buffer, int capacity, RecordType type, uint32_t tick) {
+    InitByteWriter(writer, buffer, capacity);
+    WriteU8(writer, type);
+    WriteU32(writer, tick);
+    WriteU32(writer, 0);
+}
+
+// Patches the payload length and appends the entry
+static void EndEntry(Recorder *recorder, ByteWriter *writer) {
+    if (writer->overflow) return;
+    uint32_t length = writer->size - RECORD_ENTRY_HEADER_SIZE;
+    for (int i = 0; i < 4; i++) writer->data[5 + i] = (uint8_t)(length >> (8 * i));
+    fwrite(writer->data, 1, writer->size, recorder->file);
+    recorder->bytesWritten += writer->size;
+}
+
+bool OpenRecorder(Recorder *recorder, const char *path, int tickRate, int maxPlayers) {
+    memset(recorder, 0, sizeof(*recorder));
+    recorder->file = fopen(path, "wb");
+    if (!recorder->file) return false;
+    // Large enough that the simulation thread rarely waits on the disk
+    setvbuf(recorder->file, NULL, _IOFBF, 1 << 20);
+
+    recorder->maxPlayers = maxPlayers;
+    recorder->keyframeInterval = RECORD_KEYFRAME_INTERVAL;
+    recorder->inputs = calloc(maxPlayers, sizeof(PlayerInput));
+    recorder->hasInput = calloc(maxPlayers, sizeof(bool));
+    // Room for every boat and cannonball slot to despawn and spawn in one entry
+    recorder->bufferSize = RECORD_ENTRY_HEADER_SIZE + 6 + maxPlayers * (1 + MAX_CANNONBALLS) * 26;
+    recorder->buffer = malloc(recorder->bufferSize);
+    InitNetSnapshot(&recorder->current);
+    InitNetSnapshot(&recorder->written);
+    InitNetSnapshot(&recorder->next);
+
+    uint8_t header[RECORD_HEADER_SIZE];
+    ByteWriter writer;
+    InitByteWriter(&writer, header, sizeof(header));
+    WriteU32(&writer, RECORD_MAGIC);
+    WriteU16(&writer, RECORD_VERSION);
+    WriteU16(&writer, (uint16_t)tickRate);
+    WriteU32(&writer, (uint32_t)maxPlayers);
+    WriteU32(&writer, (uint32_t)recorder->keyframeInterval);
+    fwrite(header, 1, writer.size, recorder->file);
+    recorder->bytesWritten = writer.size;
+    return true;
+}
+
+void CloseRecorder(Recorder *recorder) {
+    if (recorder->file) fclose(recorder->file);
+    free(recorder->inputs);
+    free(recorder->hasInput);
+    free(recorder->buffer);
+    FreeNetSnapshot(&recorder->current);
+    FreeNetSnapshot(&recorder->written);
+    FreeNetSnapshot(&recorder->next);
+    memset(recorder, 0, sizeof(*recorder));
+}
+
+void RecordInput(Recorder *recorder, uint32_t tick, int playerId, const PlayerInput *input) {
+    if (recorder->hasInput[playerId] && memcmp(&recorder->inputs[playerId], input, sizeof(*input)) == 0) return;
+    recorder->inputs[playerId] = *input;
+    recorder->hasInput[playerId] = true;
+
+    uint8_t buffer[RECORD_ENTRY_HEADER_SIZE + RECORD_INPUT_SIZE];
+    ByteWriter writer;
+    BeginEntry(&writer, buffer, sizeof(buffer), RECORD_INPUT, tick);
+    WriteU16(&writer, (uint16_t)playerId);
+    WriteU8(&writer, input->connected);
+    WriteF32(&writer, input->position.x);
+    WriteF32(&writer, input->position.y);
+    WriteF32(&writer, input->position.z);
+    WriteF32(&writer, input->aim.x);
+    WriteF32(&writer, input->aim.y);
+    WriteF32(&writer, input->aim.z);
+    WriteU32(&writer, input->shots);
+    EndEntry(recorder, &writer);
+}
+
+void RecordWorld(Recorder *recorder, const WorldSnapshot *world) {
+    CaptureNetSnapshot(world, &recorder->current);
+
+    bool keyframe = !recorder->hasKeyframe || world->tick - recorder->lastKeyframe >= (uint32_t)recorder->keyframeInterval;
+    if (keyframe) {
+        recorder->lastKeyframe = world->tick;
+        recorder->hasKeyframe = true;
+    }
+
+    ByteWriter writer;
+    BeginEntry(&writer, recorder->buffer, recorder->bufferSize, keyframe ? RECORD_KEYFRAME : RECORD_DELTA, world->tick);
+    WriteU32(&writer, (uint32_t)(world->tickNs / 1000));
+    WriteSnapshotDelta(&writer, keyframe ? NULL : &recorder->written, &recorder->current, &recorder->next);
+    EndEntry(recorder, &writer);
+
+    // What was written is the next entry's baseline
+    NetSnapshot previous = recorder->written;
+    recorder->written = recorder->next;
+    recorder->next = previous;
+}
+
+bool OpenReplay(Replay *replay, const char *path) {
+    memset(replay, 0, sizeof(*replay));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) < 0 || info.st_size < RECORD_HEADER_SIZE) {
+        close(fd);
+        return false;
+    }
+    void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+    // Playback reads front to back once
+    madvise(data, info.st_size, MADV_SEQUENTIAL);
+
+    ByteReader reader;
+    InitByteReader(&reader, data, RECORD_HEADER_SIZE);
+    uint32_t magic = ReadU32(&reader);
+    uint16_t version = ReadU16(&reader);
+    replay->tickRate = ReadU16(&reader);
+    replay->maxPlayers = (int)ReadU32(&reader);
+    replay->keyframeInterval = (int)ReadU32(&reader);
+    if (magic != RECORD_MAGIC || version != RECORD_VERSION || replay->tickRate <= 0 ||
+        replay->maxPlayers <= 0 || replay->maxPlayers > NET_MAX_PLAYERS) {
+        munmap(data, info.st_size);
+        return false;
+    }
+
+    replay->data = data;
+    replay->size = info.st_size;
+    replay->offset = RECORD_HEADER_SIZE;
+    return true;
+}
+
+void CloseReplay(Replay *replay) {
+    if (replay->data) munmap((void *)replay->data, replay->size);
+    memset(replay, 0, sizeof(*replay));
+}
+
+bool NextRecordEntry(Replay *replay, RecordEntry *entry) {
+    if (replay->size - replay->offset < RECORD_ENTRY_HEADER_SIZE) return false;
+    ByteReader reader;
+    InitByteReader(&reader, replay->data + replay->offset, RECORD_ENTRY_HEADER_SIZE);
+    entry->type = ReadU8(&reader);
+    entry->tick = ReadU32(&reader);
+    uint32_t length = ReadU32(&reader);
+    if (length > replay->size - replay->offset - RECORD_ENTRY_HEADER_SIZE || length > INT32_MAX) return false;
+
+    InitByteReader(&entry->payload, replay->data + replay->offset + RECORD_ENTRY_HEADER_SIZE, (int)length);
+    replay->offset += RECORD_ENTRY_HEADER_SIZE + length;
+    return true;
+}
+
+bool ReadRecordedInput(ByteReader *payload, int *playerId, PlayerInput *input) {
+    *playerId = ReadU16(payload);
+    input->connected = ReadU8(payload) != 0;
+    input->position.x = ReadF32(payload);
+    input->position.y = ReadF32(payload);
+    input->position.z = ReadF32(payload);
+    input->aim.x = ReadF32(payload);
+    input->aim.y = ReadF32(payload);
+    input->aim.z = ReadF32(payload);
+    input->shots = ReadU32(payload);
+    return !payload->error;
+}
+
+bool ReadRecordedWorld(const RecordEntry *entry, const NetSnapshot *baseline, NetSnapshot *out, uint32_t *tickUs) {
+    ByteReader payload = entry->payload;
+    *tickUs = ReadU32(&payload);
+    out->tick = entry->tick;
+    return ReadSnapshotDelta(&payload, entry->type == RECORD_KEYFRAME ? NULL : baseline, out);
+}
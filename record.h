@@ -0,0 +1,71 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include "protocol.h"
+#include <stdio.h>
+
+#define RECORD_MAGIC 0x43524246    // "FBRC"
+#define RECORD_VERSION 1
+#define RECORD_HEADER_SIZE 16
+#define RECORD_ENTRY_HEADER_SIZE 9
+// A full world every 5 seconds at the default tick rate, deltas in between
+#define RECORD_KEYFRAME_INTERVAL 300
+
+// Little-endian, like packets: the file header (u32 magic, u16 version,
+// u16 tickRate, u32 maxPlayers, u32 keyframeInterval), then entries of
+// u8 type, u32 tick, u32 payload length and the payload.
+typedef enum {
+    RECORD_INPUT = 1,      // u16 player, u8 connected, position and aim as raw floats, u32 shots
+    RECORD_DELTA,          // u32 tick time in us, world delta against the previous world entry
+    RECORD_KEYFRAME        // u32 tick time in us, full world
+} RecordType;
+
+// Appends a match to a log as it is played; owned by the simulation thread
+typedef struct Recorder {
+    FILE *file;
+    int maxPlayers;
+    int keyframeInterval;
+    uint32_t lastKeyframe;
+    bool hasKeyframe;
+    NetSnapshot current;
+    NetSnapshot written;       // the world as a reader of the log has it
+    NetSnapshot next;
+    PlayerInput *inputs;       // last input written per player, to skip repeats
+    bool *hasInput;
+    uint8_t *buffer;
+    int bufferSize;
+    uint64_t bytesWritten;
+} Recorder;
+
+// Memory-mapped log for playback
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t offset;         // next entry
+    int tickRate;
+    int maxPlayers;
+    int keyframeInterval;
+} Replay;
+
+typedef struct {
+    RecordType type;
+    uint32_t tick;         // inputs: the tick they are applied in; worlds: the tick they show
+    ByteReader payload;
+} RecordEntry;
+
+bool OpenRecorder(Recorder *recorder, const char *path, int tickRate, int maxPlayers);
+void CloseRecorder(Recorder *recorder);
+// Writes the input only when it differs from the player's last recorded one
+void RecordInput(Recorder *recorder, uint32_t tick, int playerId, const PlayerInput *input);
+// Writes a keyframe every keyframeInterval ticks and a delta otherwise
+void RecordWorld(Recorder *recorder, const WorldSnapshot *world);
+
+bool OpenReplay(Replay *replay, const char *path);
+void CloseReplay(Replay *replay);
+// Returns false at the end of the log or on a truncated entry
+bool NextRecordEntry(Replay *replay, RecordEntry *entry);
+bool ReadRecordedInput(ByteReader *payload, int *playerId, PlayerInput *input);
+// `baseline` is the previous decoded world; keyframes ignore it
+bool ReadRecordedWorld(const RecordEntry *entry, const NetSnapshot *baseline, NetSnapshot *out, uint32_t *tickUs);
+
+#endif
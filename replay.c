@@ -0,0 +1,183 @@
+#include "client.h"
+#include "record.h"
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Growable list of samples for percentiles
+typedef struct {
+    uint32_t *values;
+    int count;
+    int capacity;
+} Samples;
+
+typedef struct {
+    Samples stepNs;        // StepSim per tick
+    Samples decodeNs;      // log entry to drawable world per tick
+    uint32_t ticks;
+    uint32_t mismatches;   // re-simulated ticks that differ from the recording
+    uint64_t entities;     // boats and cannonballs summed over every tick
+} ReplayResult;
+
+static int64_t NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void AddSample(Samples *samples, uint32_t value) {
+    if (samples->count == samples->capacity) {
+        samples->capacity = samples->capacity ? samples->capacity * 2 : 1024;
+        samples->values = realloc(samples->values, samples->capacity * sizeof(uint32_t));
+    }
+    samples->values[samples->count++] = value;
+}
+
+static int CompareU32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples
+static uint32_t Percentile(const Samples *samples, double p) {
+    if (samples->count == 0) return 0;
+    int rank = (int)ceil(p / 100.0 * samples->count) - 1;
+    if (rank < 0) rank = 0;
+    return samples->values[rank];
+}
+
+static bool SameEntity(const NetEntity *a, const NetEntity *b) {
+    return a->kind == b->kind && a->id == b->id && a->value == b->value && a->startTick == b->startTick &&
+           memcmp(a->position, b->position, sizeof(a->position)) == 0 &&
+           memcmp(a->direction, b->direction, sizeof(a->direction)) == 0;
+}
+
+static bool SameSnapshot(const NetSnapshot *a, const NetSnapshot *b) {
+    if (a->count != b->count) return false;
+    for (int i = 0; i < a->count; i++) {
+        if (!SameEntity(&a->entities[i], &b->entities[i])) return false;
+    }
+    return true;
+}
+
+// One pass over the log: re-simulates every tick from the recorded inputs and
+// compares it with the recorded world, then decodes that world the way a
+// client does before drawing it
+static bool RunReplay(Replay *replay, ReplayResult *result) {
+    static Sim sim;
+    InitSim(&sim, replay->tickRate, replay->maxPlayers);
+    WorldSnapshot world;
+    InitWorldSnapshot(&world, replay->maxPlayers);
+    NetSnapshot recorded[2], simulated;
+    InitNetSnapshot(&recorded[0]);
+    InitNetSnapshot(&recorded[1]);
+    InitNetSnapshot(&simulated);
+    int current = 0;
+    bool ok = true;
+
+    replay->offset = RECORD_HEADER_SIZE;
+    RecordEntry entry;
+    while (ok && NextRecordEntry(replay, &entry)) {
+        if (entry.type == RECORD_INPUT) {
+            int playerId;
+            PlayerInput input;
+            ok = ReadRecordedInput(&entry.payload, &playerId, &input) && playerId < replay->maxPlayers;
+            if (ok) SubmitInput(&sim, playerId, &input);
+            continue;
+        }
+        if (entry.type != RECORD_DELTA && entry.type != RECORD_KEYFRAME) continue;
+
+        // The inputs of a tick come before the world it produced
+        while (ok && sim.tick < entry.tick) {
+            int64_t start = NowNs();
+            StepSim(&sim);
+            AddSample(&result->stepNs, (uint32_t)(NowNs() - start));
+        }
+
+        int64_t start = NowNs();
+        uint32_t tickUs;
+        ok = ReadRecordedWorld(&entry, &recorded[current], &recorded[current ^ 1], &tickUs);
+        current ^= 1;
+        NetViewToWorld(&recorded[current], replay->tickRate, &world);
+        AddSample(&result->decodeNs, (uint32_t)(NowNs() - start));
+
+        WorldSnapshot simWorld = {
+            .tick = sim.tick, .playerCount = sim.maxPlayers, .players = sim.players, .projectiles = sim.projectiles
+        };
+        CaptureNetSnapshot(&simWorld, &simulated);
+        if (!SameSnapshot(&simulated, &recorded[current])) result->mismatches++;
+        result->entities += recorded[current].count;
+        result->ticks++;
+    }
+
+    FreeNetSnapshot(&recorded[0]);
+    FreeNetSnapshot(&recorded[1]);
+    FreeNetSnapshot(&simulated);
+    FreeWorldSnapshot(&world);
+    FreeSim(&sim);
+    return ok;
+}
+
+static void PrintUsage(const char *program) {
+    printf("Usage: %s [--loops N] FILE\n", program);
+    printf("  --loops  passes over the recording, timings cover all of them (default 1)\n");
+}
+
+// Plays a recorded match back headlessly as fast as possible, as a repeatable benchmark
+int main(int argc, char **argv) {
+    int loops = 1;
+    static const struct option options[] = {
+        {"loops", required_argument, NULL, 'l'},
+        {"help", no_argument, NULL, 'h'},
+        {0}
+    };
+    int option;
+    while ((option = getopt_long(argc, argv, "l:h", options, NULL)) != -1) {
+        switch (option) {
+            case 'l': loops = atoi(optarg); break;
+            case 'h': PrintUsage(argv[0]); return 0;
+            default: PrintUsage(argv[0]); return 1;
+        }
+    }
+    if (optind != argc - 1 || loops <= 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    Replay replay;
+    if (!OpenReplay(&replay, argv[optind])) {
+        printf("Error: Could not open recording %s.\n", argv[optind]);
+        return 1;
+    }
+
+    ReplayResult result = { 0 };
+    int64_t start = NowNs();
+    bool ok = true;
+    for (int loop = 0; ok && loop < loops; loop++) ok = RunReplay(&replay, &result);
+    double seconds = (NowNs() - start) / 1e9;
+    CloseReplay(&replay);
+    if (!ok) printf("Error: Recording is truncated or corrupt, stopped after %u ticks.\n", result.ticks);
+
+    qsort(result.stepNs.values, result.stepNs.count, sizeof(uint32_t), CompareU32);
+    qsort(result.decodeNs.values, result.decodeNs.count, sizeof(uint32_t), CompareU32);
+    double perEntity = 0.0;
+    if (result.entities > 0) {
+        uint64_t total = 0;
+        for (int i = 0; i < result.stepNs.count; i++) total += result.stepNs.values[i];
+        perEntity = (double)total / result.entities;
+    }
+
+    printf("%u ticks in %.2f s (%.0f ticks/s), %u differ from the recording\n", result.ticks, seconds,
+           result.ticks / seconds, result.mismatches);
+    printf("step p50/p99/max %u/%u/%u ns, %.1f ns per entity\n", Percentile(&result.stepNs, 50),
+           Percentile(&result.stepNs, 99), Percentile(&result.stepNs, 100), perEntity);
+    printf("decode p50/p99/max %u/%u/%u ns\n", Percentile(&result.decodeNs, 50), Percentile(&result.decodeNs, 99),
+           Percentile(&result.decodeNs, 100));
+
+    free(result.stepNs.values);
+    free(result.decodeNs.values);
+    return ok && result.mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,590 @@
+#define _GNU_SOURCE
+#include "server.h"
+#include "profiler.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+// epoll_event.data of the server's descriptors
+enum { EVENT_UDP = 1, EVENT_TIMER, EVENT_WAKE };
+
+static int64_t NowMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Writes a small packet of u16 fields, returns its size
+static int BuildPacket(uint8_t *buffer, int capacity, PacketType type, uint32_t tick, const uint16_t *payload, int count) {
+    ByteWriter writer;
+    BeginPacket(&writer, buffer, capacity, type, tick);
+    for (int i = 0; i < count; i++) WriteU16(&writer, payload[i]);
+    return EndPacket(&writer);
+}
+
+static void SendUdpPacket(int udp_fd, const struct sockaddr_in *to, PacketType type, uint32_t tick, const uint16_t *payload, int count) {
+    uint8_t buffer[PACKET_HEADER_SIZE + 8];
+    int size = BuildPacket(buffer, sizeof(buffer), type, tick, payload, count);
+    if (size > 0 && sendto(udp_fd, buffer, size, 0, (const struct sockaddr *)to, sizeof(*to)) > 0) {
+        PROFILE_COUNT(COUNTER_BYTES_SENT, size);
+    }
+}
+
+// PING or PONG to one peer, counted in its telemetry
+static void SendUdpPing(Server *server, UdpPeer *peer, PacketType type, uint32_t sequence, uint32_t timeUs) {
+    uint8_t buffer[PACKET_HEADER_SIZE + 4];
+    int size = BuildPingPacket(buffer, sizeof(buffer), type, sequence, timeUs);
+    if (size > 0 && sendto(server->udpFd, buffer, size, 0, (const struct sockaddr *)&peer->address, sizeof(peer->address)) > 0) {
+        PROFILE_COUNT(COUNTER_BYTES_SENT, size);
+        CountSent(&peer->link.counters, size);
+    } else {
+        CountDropped(&peer->link.counters);
+    }
+}
+
+static int AllocPlayerSlot(Room *room) {
+    if (room->freeSlotCount == 0) return -1;
+    int id = room->freeSlots[--room->freeSlotCount];
+    room->inputs[id] = (PlayerInput){ .connected = true };
+    SubmitInput(room->sim, id, &room->inputs[id]);
+    return id;
+}
+
+static void FreePlayerSlot(Room *room, int id) {
+    room->inputs[id].connected = false;
+    SubmitInput(room->sim, id, &room->inputs[id]);
+    room->freeSlots[room->freeSlotCount++] = id;
+}
+
+// Matches fill up one after another rather than spreading a few players over each
+static int JoinRoom(Server *server, int *id) {
+    for (int r = 0; r < server->roomCount; r++) {
+        if ((*id = AllocPlayerSlot(&server->rooms[r])) >= 0) return r;
+    }
+    return -1;
+}
+
+// WELCOME payload: player id, tick rate, player capacity
+static void FillWelcome(Room *room, int id, uint16_t *welcome) {
+    welcome[0] = (uint16_t)id;
+    welcome[1] = (uint16_t)room->sim->tickRate;
+    welcome[2] = (uint16_t)room->sim->maxPlayers;
+}
+
+// Address lookup for UDP peers: open addressing with linear probing, keyed on ip and port
+static uint32_t HashAddress(const struct sockaddr_in *address) {
+    uint64_t key = ((uint64_t)address->sin_addr.s_addr << 16) | address->sin_port;
+    key *= 0x9E3779B97F4A7C15ull;
+    return (uint32_t)(key >> 32);
+}
+
+static bool SameAddress(const struct sockaddr_in *a, const struct sockaddr_in *b) {
+    return a->sin_addr.s_addr == b->sin_addr.s_addr && a->sin_port == b->sin_port;
+}
+
+// Table entries are room * maxPlayers + player id
+static UdpPeer *GetUdpPeer(const Server *server, int handle) {
+    return &server->rooms[handle / server->maxPlayers].peers[handle % server->maxPlayers];
+}
+
+static int FindUdpPeer(const Server *server, const struct sockaddr_in *from) {
+    for (uint32_t h = HashAddress(from) & server->peerTableMask;; h = (h + 1) & server->peerTableMask) {
+        int handle = server->peerTable[h];
+        if (handle < 0) return -1;
+        if (SameAddress(&GetUdpPeer(server, handle)->address, from)) return handle;
+    }
+}
+
+static void InsertUdpPeer(Server *server, int handle) {
+    uint32_t h = HashAddress(&GetUdpPeer(server, handle)->address) & server->peerTableMask;
+    while (server->peerTable[h] >= 0) h = (h + 1) & server->peerTableMask;
+    server->peerTable[h] = handle;
+}
+
+static void RemoveUdpPeer(Server *server, int handle) {
+    uint32_t mask = server->peerTableMask;
+    uint32_t h = HashAddress(&GetUdpPeer(server, handle)->address) & mask;
+    while (server->peerTable[h] != handle) h = (h + 1) & mask;
+
+    // Shift later entries of the probe run back so lookups never stop at the hole
+    for (uint32_t next = (h + 1) & mask; server->peerTable[next] >= 0; next = (next + 1) & mask) {
+        uint32_t home = HashAddress(&GetUdpPeer(server, server->peerTable[next])->address) & mask;
+        if (((next - home) & mask) >= ((next - h) & mask)) {
+            server->peerTable[h] = server->peerTable[next];
+            h = next;
+        }
+    }
+    server->peerTable[h] = -1;
+}
+
+// History is left alone: the worker may still be writing it, and a newcomer in the
+// same slot starts with ackedTick 0, so it only ever acks snapshots sent to itself
+static void DropUdpPeer(Server *server, int roomIndex, int id) {
+    Room *room = &server->rooms[roomIndex];
+    UdpPeer *peer = &room->peers[id];
+    RemoveUdpPeer(server, roomIndex * server->maxPlayers + id);
+
+    PROFILE_LOCK(&room->mutex);
+    peer->active = false;
+    int last = room->activePeers[--room->activePeerCount];
+    room->activePeers[peer->activeIndex] = last;
+    room->peers[last].activeIndex = peer->activeIndex;
+    pthread_mutex_unlock(&room->mutex);
+    FreePlayerSlot(room, id);
+}
+
+static int AddUdpPeer(Server *server, const struct sockaddr_in *from) {
+    int id, roomIndex = JoinRoom(server, &id);
+    if (roomIndex < 0) return -1;
+    Room *room = &server->rooms[roomIndex];
+    UdpPeer *peer = &room->peers[id];
+
+    PROFILE_LOCK(&room->mutex);
+    peer->active = true;
+    peer->address = *from;
+    peer->inputSequence = 0;
+    atomic_store_explicit(&peer->ackedTick, 0, memory_order_relaxed);
+    InitLinkTelemetry(&peer->link, NowMs());
+    peer->activeIndex = room->activePeerCount;
+    room->activePeers[room->activePeerCount++] = id;
+    pthread_mutex_unlock(&room->mutex);
+
+    int handle = roomIndex * server->maxPlayers + id;
+    InsertUdpPeer(server, handle);
+    return handle;
+}
+
+static void HandleUdpPacket(Server *server, const uint8_t *buffer, int size, const struct sockaddr_in *from) {
+    ByteReader reader;
+    PacketHeader header;
+    InitByteReader(&reader, buffer, size);
+    if (!ReadPacketHeader(&reader, &header)) return;
+
+    int handle = FindUdpPeer(server, from);
+    if (header.type == PACKET_HELLO) {
+        if (handle < 0) handle = AddUdpPeer(server, from);
+        if (handle < 0) {
+            SendUdpPacket(server->udpFd, from, PACKET_BYE, 0, NULL, 0);
+            return;
+        }
+        uint16_t welcome[3];
+        FillWelcome(&server->rooms[handle / server->maxPlayers], handle % server->maxPlayers, welcome);
+        SendUdpPacket(server->udpFd, from, PACKET_WELCOME, 0, welcome, 3);
+        UdpPeer *peer = GetUdpPeer(server, handle);
+        peer->lastHeardMs = NowMs();
+        CountReceived(&peer->link.counters, size);
+        return;
+    }
+    if (handle < 0) return;
+
+    Room *room = &server->rooms[handle / server->maxPlayers];
+    int id = handle % server->maxPlayers;
+    UdpPeer *peer = &room->peers[id];
+    peer->lastHeardMs = NowMs();
+    CountReceived(&peer->link.counters, size);
+
+    if (header.type == PACKET_BYE) {
+        DropUdpPeer(server, handle / server->maxPlayers, id);
+    } else if (header.type == PACKET_INPUT && (int32_t)(header.tick - peer->inputSequence) > 0) {
+        // Late or duplicated inputs are older than what the sim already has
+        PlayerInput input;
+        uint32_t ackTick;
+        if (!ReadInput(&reader, &input, &ackTick)) return;
+        peer->inputSequence = header.tick;
+        room->inputs[id] = input;
+        SubmitInput(room->sim, id, &room->inputs[id]);
+
+        // The sender checks the ack against its history before using it as a baseline
+        uint32_t ackedTick = atomic_load_explicit(&peer->ackedTick, memory_order_relaxed);
+        if (ackTick != 0 && (int32_t)(ackTick - ackedTick) > 0) {
+            atomic_store_explicit(&peer->ackedTick, ackTick, memory_order_relaxed);
+        }
+    } else if (header.type == PACKET_PING) {
+        uint32_t timeUs = ReadU32(&reader);
+        if (!reader.error) SendUdpPing(server, peer, PACKET_PONG, header.tick, timeUs);
+    } else if (header.type == PACKET_PONG) {
+        uint32_t timeUs = ReadU32(&reader);
+        if (!reader.error) ReceivePong(&peer->link, header.tick, GetTelemetryClockUs() - timeUs);
+    }
+}
+
+static void ReadUdpPackets(Server *server) {
+    uint8_t buffer[PACKET_MAX_SIZE];
+    struct sockaddr_in from;
+    socklen_t fromlen = sizeof(from);
+    ssize_t size;
+    while ((size = recvfrom(server->udpFd, buffer, sizeof(buffer), 0, (struct sockaddr *)&from, &fromlen)) >= 0) {
+        PROFILE_COUNT(COUNTER_BYTES_RECEIVED, size);
+        if (size > 0) HandleUdpPacket(server, buffer, (int)size, &from);
+        fromlen = sizeof(from);
+    }
+}
+
+// Snapshot packets of one tick, sent with one system call per batch
+typedef struct SendBatch {
+    uint8_t packets[UDP_SEND_BATCH][PACKET_MAX_SIZE];
+    struct iovec iovecs[UDP_SEND_BATCH];
+    struct mmsghdr messages[UDP_SEND_BATCH];
+    int ids[UDP_SEND_BATCH];   // peer each packet goes to
+    int count;
+} SendBatch;
+
+// Hands the batch to the kernel in one call. Returns false once the socket's send
+// buffer is full; whatever didn't fit is dropped, those peers get the next tick.
+static bool FlushSendBatch(Server *server, Room *room, SendBatch *batch) {
+    int sent = 0;
+    while (sent < batch->count) {
+        int result = sendmmsg(server->udpFd, batch->messages + sent, batch->count - sent, 0);
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) break;
+        for (int i = sent; i < sent + result; i++) {
+            PROFILE_COUNT(COUNTER_BYTES_SENT, batch->messages[i].msg_len);
+            CountSent(&room->peers[batch->ids[i]].link.counters, batch->messages[i].msg_len);
+        }
+        sent += result;
+    }
+    PROFILE_COUNT(COUNTER_SNAPSHOTS_SKIPPED, batch->count - sent);
+    for (int i = sent; i < batch->count; i++) CountDropped(&room->peers[batch->ids[i]].link.counters);
+    bool flushed = sent == batch->count;
+    batch->count = 0;
+    return flushed;
+}
+
+// Sends each of the room's UDP peers the changes to its area of interest since the
+// last snapshot it acknowledged; entities entering or leaving the area go out as
+// spawns and despawns. Records are encoded once per tick and copied into each
+// peer's packet. Runs on the network thread or on the room's worker.
+static void SendUdpSnapshots(Server *server, Room *room, const WorldSnapshot *world) {
+    const NetSnapshot *current = &room->interestView;
+    SendBatch *batch = room->batch;
+
+    PROFILE_LOCK(&room->mutex);
+    int targetCount = room->activePeerCount;
+    for (int a = 0; a < targetCount; a++) {
+        int id = room->activePeers[a];
+        room->targets[a] = (PeerTarget){ .id = id, .address = room->peers[id].address };
+    }
+    pthread_mutex_unlock(&room->mutex);
+    if (targetCount == 0) return;
+
+    BuildInterestGrid(&room->interest, &room->current, room->sim->tickRate);
+    EncodeSharedRecords(&room->shared, &room->current);
+
+    // When the send buffer fills up the rest of the peers skip this tick; starting
+    // somewhere else each tick keeps that from always hitting the same ones
+    int first = room->current.tick % targetCount;
+    for (int a = 0; a < targetCount; a++) {
+        PeerTarget *target = &room->targets[(first + a) % targetCount];
+        UdpPeer *peer = &room->peers[target->id];
+        const BoatPosition *position = &world->players[target->id].position;
+        GatherInterest(&room->interest, &room->current, target->id, position->x, position->z, INTEREST_RADIUS, &room->interestView);
+
+        const NetSnapshot *baseline = NULL;
+        uint32_t ackedTick = atomic_load_explicit(&peer->ackedTick, memory_order_relaxed);
+        if (ackedTick != 0 && current->tick - ackedTick < NET_SNAPSHOT_HISTORY) {
+            baseline = &peer->history[ackedTick % NET_SNAPSHOT_HISTORY];
+            if (baseline->tick != ackedTick) baseline = NULL;
+        }
+
+        ByteWriter writer;
+        BeginPacket(&writer, batch->packets[batch->count], PACKET_MAX_SIZE, PACKET_SNAPSHOT, current->tick);
+        WriteU32(&writer, baseline ? baseline->tick : 0);
+        WriteU32(&writer, atomic_load_explicit(&room->tickUs, memory_order_relaxed));
+        WriteU32(&writer, atomic_load_explicit(&room->overruns, memory_order_relaxed));
+        WriteSharedSnapshotDelta(&writer, baseline, current, room->interest.selected, &room->shared,
+                                 &peer->history[current->tick % NET_SNAPSHOT_HISTORY]);
+        int size = EndPacket(&writer);
+        if (size <= 0) continue;
+
+        batch->ids[batch->count] = target->id;
+        batch->iovecs[batch->count] = (struct iovec){ .iov_base = batch->packets[batch->count], .iov_len = size };
+        batch->messages[batch->count] = (struct mmsghdr){ .msg_hdr = {
+            .msg_name = &target->address, .msg_namelen = sizeof(target->address),
+            .msg_iov = &batch->iovecs[batch->count], .msg_iovlen = 1
+        } };
+        if (++batch->count == UDP_SEND_BATCH && !FlushSendBatch(server, room, batch)) {
+            PROFILE_COUNT(COUNTER_SNAPSHOTS_SKIPPED, targetCount - a - 1);
+            for (int b = a + 1; b < targetCount; b++) CountDropped(&room->peers[room->targets[(first + b) % targetCount].id].link.counters);
+            return;
+        }
+    }
+    if (batch->count > 0) FlushSendBatch(server, room, batch);
+}
+
+static void SendRoomSnapshots(Server *server, Room *room) {
+    const WorldSnapshot *world = AcquireSnapshot(room->sim, room->snapshotReader);
+    if (world->tick == room->lastSentTick) return;
+    room->lastSentTick = world->tick;
+    atomic_store_explicit(&room->tickUs, (uint32_t)(world->tickNs / 1000), memory_order_relaxed);
+    atomic_store_explicit(&room->overruns, world->overruns, memory_order_relaxed);
+    PROFILE_BEGIN(PHASE_SERVER_SEND);
+    CaptureNetSnapshot(world, &room->current);
+    SendUdpSnapshots(server, room, world);
+    PROFILE_END(PHASE_SERVER_SEND);
+}
+
+// Worker pool task: one tick of one room, then its snapshots
+static void TickRoom(void *context, int roomIndex) {
+    Server *server = (Server *)context;
+    Room *room = &server->rooms[roomIndex];
+    room->sim->overruns += atomic_exchange(&room->missedTicks, 0);
+    StepSim(room->sim);
+    SendRoomSnapshots(server, room);
+    atomic_store(&room->busy, false);
+}
+
+// Pings the peer when one is due and logs its telemetry window once that closes.
+// Returns true when it wrote a row.
+static bool UpdatePeerTelemetry(Server *server, int roomIndex, int id, int64_t now, int sendQueueBytes) {
+    Room *room = &server->rooms[roomIndex];
+    UdpPeer *peer = &room->peers[id];
+    uint32_t sequence;
+    if (NextPing(&peer->link, now, &sequence)) SendUdpPing(server, peer, PACKET_PING, sequence, GetTelemetryClockUs());
+
+    LinkStats stats;
+    if (!CloseLinkWindow(&peer->link, now, &stats) || !server->telemetry) return false;
+    // UDP peers share the one socket, so they share its queue too
+    stats.sendQueueBytes = sendQueueBytes;
+    stats.tickUs = atomic_load_explicit(&room->tickUs, memory_order_relaxed);
+    stats.overruns = atomic_load_explicit(&room->overruns, memory_order_relaxed);
+
+    char ip[INET_ADDRSTRLEN], name[INET_ADDRSTRLEN + 8];
+    inet_ntop(AF_INET, &peer->address.sin_addr, ip, sizeof(ip));
+    snprintf(name, sizeof(name), "%s:%d", ip, ntohs(peer->address.sin_port));
+    WriteLinkStats(server->telemetry, roomIndex, id, name, &stats);
+    return true;
+}
+
+static void OnServerTick(Server *server) {
+    uint64_t expirations;
+    read(server->timerFd, &expirations, sizeof(expirations));
+
+    int64_t now = NowMs();
+    int sendQueueBytes = server->telemetry ? GetSendQueueBytes(server->udpFd) : 0;
+    bool logged = false;
+    for (int r = 0; r < server->roomCount; r++) {
+        Room *room = &server->rooms[r];
+        for (int a = room->activePeerCount - 1; a >= 0; a--) {
+            int id = room->activePeers[a];
+            if (now - room->peers[id].lastHeardMs > UDP_PEER_TIMEOUT_MS) DropUdpPeer(server, r, id);
+            else logged |= UpdatePeerTelemetry(server, r, id, now, sendQueueBytes);
+        }
+    }
+    if (logged) FlushTelemetryLog(server->telemetry);
+
+    if (!server->pool) {
+        for (int r = 0; r < server->roomCount; r++) SendRoomSnapshots(server, &server->rooms[r]);
+        return;
+    }
+    // A room still busy with its last tick skips this one; the sim counts it as an overrun
+    for (int r = 0; r < server->roomCount; r++) {
+        Room *room = &server->rooms[r];
+        if (expirations > 1) atomic_fetch_add(&room->missedTicks, (uint32_t)(expirations - 1));
+        if (atomic_exchange(&room->busy, true)) {
+            atomic_fetch_add(&room->missedTicks, 1);
+        } else {
+            SubmitTask(server->pool, r);
+        }
+    }
+}
+
+static void InitRoom(Room *room, Sim *sim, int reservedPlayers) {
+    room->sim = sim;
+    room->snapshotReader = OpenSnapshotReader(sim);
+    pthread_mutex_init(&room->mutex, NULL);
+
+    int maxPlayers = sim->maxPlayers;
+    room->inputs = calloc(maxPlayers, sizeof(PlayerInput));
+    room->peers = calloc(maxPlayers, sizeof(UdpPeer));
+    room->activePeers = calloc(maxPlayers, sizeof(int));
+    room->targets = calloc(maxPlayers, sizeof(PeerTarget));
+    room->freeSlots = calloc(maxPlayers, sizeof(int));
+    // Hand out low ids first; ids below reservedPlayers belong to local players
+    for (int id = maxPlayers - 1; id >= reservedPlayers; id--) room->freeSlots[room->freeSlotCount++] = id;
+
+    InitNetSnapshot(&room->current);
+    InitNetSnapshot(&room->interestView);
+    InitSharedRecords(&room->shared);
+    room->batch = malloc(sizeof(SendBatch));
+    room->batch->count = 0;
+    InitInterestGrid(&room->interest, WATER_WIDTH, WATER_LENGTH, INTEREST_CELL_SIZE, maxPlayers);
+}
+
+static void FreeRoom(Room *room) {
+    for (int i = 0; i < room->sim->maxPlayers; i++) {
+        for (int h = 0; h < NET_SNAPSHOT_HISTORY; h++) FreeNetSnapshot(&room->peers[i].history[h]);
+    }
+    FreeNetSnapshot(&room->current);
+    FreeNetSnapshot(&room->interestView);
+    FreeSharedRecords(&room->shared);
+    free(room->batch);
+    FreeInterestGrid(&room->interest);
+    free(room->inputs);
+    free(room->peers);
+    free(room->activePeers);
+    free(room->targets);
+    free(room->freeSlots);
+    pthread_mutex_destroy(&room->mutex);
+}
+
+static bool OpenServer(Server *server, ServerData *serverData) {
+    memset(server, 0, sizeof(*server));
+    server->wakeFd = serverData->wakeFd;
+    server->telemetry = serverData->telemetry;
+    server->udpFd = server->timerFd = server->epollFd = -1;
+
+    Sim *sims = serverData->sim;
+    server->roomCount = serverData->roomCount;
+    server->maxPlayers = sims[0].maxPlayers;
+    server->rooms = calloc(server->roomCount, sizeof(Room));
+    for (int r = 0; r < server->roomCount; r++) InitRoom(&server->rooms[r], &sims[r], r == 0 ? serverData->reservedPlayers : 0);
+
+    int tableSize = 16;
+    while (tableSize < server->roomCount * server->maxPlayers * 2) tableSize *= 2;
+    server->peerTable = malloc(tableSize * sizeof(int));
+    server->peerTableMask = tableSize - 1;
+    for (int i = 0; i < tableSize; i++) server->peerTable[i] = -1;
+
+    struct sockaddr_in address = {.sin_family = AF_INET, .sin_addr.s_addr = INADDR_ANY, .sin_port = htons(serverData->serverPort)};
+    long tickNs = 1000000000L / sims[0].tickRate;
+    // tv_nsec has to stay below a second, which a 1 Hz tick reaches
+    struct timespec tick = {.tv_sec = tickNs / 1000000000L, .tv_nsec = tickNs % 1000000000L};
+    struct itimerspec period = {.it_interval = tick, .it_value = tick};
+
+    if ((server->udpFd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0)) < 0 ||
+        bind(server->udpFd, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+        (server->timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK)) < 0 || timerfd_settime(server->timerFd, 0, &period, NULL) < 0 ||
+        (server->epollFd = epoll_create1(0)) < 0) {
+        return false;
+    }
+    // Best effort: a smaller buffer only means snapshots get skipped sooner under load
+    int sendBuffer = UDP_SEND_BUFFER_SIZE;
+    setsockopt(server->udpFd, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+
+    struct { int fd; uint64_t tag; } sources[] = {
+        {server->udpFd, EVENT_UDP}, {server->timerFd, EVENT_TIMER}, {server->wakeFd, EVENT_WAKE}
+    };
+    for (int i = 0; i < 3; i++) {
+        struct epoll_event event = {.events = EPOLLIN | EPOLLET, .data.u64 = sources[i].tag};
+        if (epoll_ctl(server->epollFd, EPOLL_CTL_ADD, sources[i].fd, &event) < 0) return false;
+    }
+
+    if (serverData->workerCount > 0) {
+        server->pool = malloc(sizeof(WorkerPool));
+        if (!StartWorkerPool(server->pool, serverData->workerCount, server->roomCount, TickRoom, server)) {
+            free(server->pool);
+            server->pool = NULL;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void CloseServer(Server *server) {
+    // Lets the rooms finish the tick they're on before their state goes away
+    if (server->pool) {
+        StopWorkerPool(server->pool);
+        free(server->pool);
+    }
+    for (int r = 0; r < server->roomCount; r++) {
+        Room *room = &server->rooms[r];
+        while (room->activePeerCount > 0) DropUdpPeer(server, r, room->activePeers[0]);
+        FreeRoom(room);
+    }
+    free(server->rooms);
+    free(server->peerTable);
+
+    if (server->epollFd >= 0) close(server->epollFd);
+    if (server->timerFd >= 0) close(server->timerFd);
+    if (server->udpFd >= 0) close(server->udpFd);
+}
+
+void InitServerData(ServerData *serverData, Sim *sim) {
+    memset(serverData, 0, sizeof(*serverData));
+    pthread_mutex_init(&serverData->mutex, NULL);
+    serverData->sim = sim;
+    serverData->roomCount = 1;
+    serverData->wakeFd = -1;
+}
+
+bool StartServer(ServerData *serverData) {
+    if (serverData->serverPort == 0) {
+        srand(time(NULL));
+        serverData->serverPort = rand() % (65535 - 1024) + 1024;
+    }
+
+    serverData->wakeFd = eventfd(0, EFD_NONBLOCK);
+    serverData->server = malloc(sizeof(Server));
+    if (!OpenServer(serverData->server, serverData)) {
+        StopServer(serverData);
+        return false;
+    }
+
+    PROFILE_LOCK(&serverData->mutex);
+    serverData->serverRunning = true;
+    pthread_mutex_unlock(&serverData->mutex);
+
+    serverData->threadStarted = pthread_create(&serverData->thread, NULL, ServerMode, serverData) == 0;
+    if (!serverData->threadStarted) StopServer(serverData);
+    return serverData->threadStarted;
+}
+
+void StopServer(ServerData *serverData) {
+    PROFILE_LOCK(&serverData->mutex);
+    serverData->serverRunning = false;
+    pthread_mutex_unlock(&serverData->mutex);
+
+    if (serverData->threadStarted) {
+        uint64_t one = 1;
+        write(serverData->wakeFd, &one, sizeof(one));
+        pthread_join(serverData->thread, NULL);
+        serverData->threadStarted = false;
+    }
+    if (serverData->server) {
+        CloseServer(serverData->server);
+        free(serverData->server);
+        serverData->server = NULL;
+    }
+    if (serverData->wakeFd >= 0) close(serverData->wakeFd);
+    serverData->wakeFd = -1;
+}
+
+void *ServerMode(void *args) {
+    ServerData *serverData = (ServerData *)args;
+    Server *server = serverData->server;
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    bool running = true;
+
+    while (running) {
+        // Only descriptors with something to do come back, however many clients are connected
+        PROFILE_BEGIN(PHASE_SERVER_WAIT);
+        int count = epoll_wait(server->epollFd, events, SERVER_MAX_EVENTS, -1);
+        PROFILE_END(PHASE_SERVER_WAIT);
+        if (count < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < count; i++) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == EVENT_UDP) {
+                PROFILE_BEGIN(PHASE_SERVER_READ);
+                ReadUdpPackets(server);
+                PROFILE_END(PHASE_SERVER_READ);
+            } else if (tag == EVENT_TIMER) {
+                OnServerTick(server);
+            } else if (tag == EVENT_WAKE) {
+                uint64_t value;
+                read(server->wakeFd, &value, sizeof(value));
+                PROFILE_LOCK(&serverData->mutex);
+                running = serverData->serverRunning;
+                pthread_mutex_unlock(&serverData->mutex);
+            }
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,109 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "sim.h"
+#include "protocol.h"
+#include "interest.h"
+#include "telemetry.h"
+#include "workers.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+
+#define UDP_PEER_TIMEOUT_MS 5000
+#define SERVER_MAX_EVENTS 64
+// Snapshot packets handed to the kernel per sendmmsg call
+#define UDP_SEND_BATCH 64
+// Asked for so one tick of every room fits; the kernel may cap it lower
+#define UDP_SEND_BUFFER_SIZE (4 << 20)
+
+// A UDP client and the snapshots it was sent, kept as delta baselines. With a
+// worker pool the room's worker owns history; the network thread owns the rest
+// and only changes membership under the room's mutex.
+typedef struct {
+    bool active;
+    int activeIndex;       // position in Room.activePeers
+    struct sockaddr_in address;
+    uint32_t inputSequence;
+    _Atomic uint32_t ackedTick;
+    int64_t lastHeardMs;
+    LinkTelemetry link;    // the sender counts snapshots into it, pings and windows are the network thread's
+    NetSnapshot history[NET_SNAPSHOT_HISTORY];
+} UdpPeer;
+
+// Who a room's snapshots go to this tick, copied out under the room's mutex
+typedef struct {
+    int id;
+    struct sockaddr_in address;
+} PeerTarget;
+
+// One independent match: its simulation, its players and their snapshot state
+typedef struct {
+    Sim *sim;
+    int snapshotReader;
+    pthread_mutex_t mutex;     // guards activePeers and the peers' membership
+
+    PlayerInput *inputs;   // latest input per player id
+    int *freeSlots;        // stack of unused player ids
+    int freeSlotCount;
+
+    UdpPeer *peers;        // by player id
+    int *activePeers;      // ids of active peers, so per-tick work skips empty slots
+    int activePeerCount;
+    PeerTarget *targets;   // scratch for the tick being sent
+
+    NetSnapshot current;
+    SharedRecords shared;      // current's records, encoded once for all peers
+    struct SendBatch *batch;   // packets waiting for sendmmsg, defined in server.c
+    InterestGrid interest;     // where the current snapshot's entities are
+    NetSnapshot interestView;  // scratch: the part of current one peer gets
+    uint32_t lastSentTick;
+    _Atomic uint32_t tickUs;       // sim timing of the current snapshot, reported to clients and in telemetry
+    _Atomic uint32_t overruns;
+
+    atomic_bool busy;              // queued or running on the worker pool
+    _Atomic uint32_t missedTicks;  // ticks skipped because the last one hadn't finished
+} Room;
+
+// Everything the network thread owns
+typedef struct {
+    Room *rooms;
+    int roomCount;
+    int maxPlayers;        // per room
+    WorkerPool *pool;      // NULL when every sim runs its own thread
+    int epollFd, udpFd, timerFd, wakeFd;
+
+    int *peerTable;        // address hash -> room * maxPlayers + player id, -1 when empty
+    uint32_t peerTableMask;
+
+    TelemetryLog *telemetry;   // NULL unless ServerData.telemetry was set
+} Server;
+
+// Shared between the thread that starts the server and the server thread
+typedef struct {
+    pthread_mutex_t mutex;
+    bool serverRunning;
+    int serverPort;        // 0 picks a random port, set to the bound port once started
+    char serverIp[INET_ADDRSTRLEN];
+    Sim *sim;              // roomCount independent matches, remote players' inputs go straight into them
+    int roomCount;         // 1 unless set before StartServer; every sim needs the same tick rate and capacity
+    int workerCount;       // 0: the caller runs each sim's own thread, otherwise the server ticks the rooms on this many workers
+    int reservedPlayers;   // player ids below this are played locally, e.g. the host is player 0 of room 0
+    TelemetryLog *telemetry;   // gets a row per UDP peer every TELEMETRY_WINDOW_MS when set; the caller opens and closes it
+    int wakeFd;            // eventfd that gets the server thread out of epoll_wait
+    pthread_t thread;
+    bool threadStarted;
+    Server *server;
+} ServerData;
+
+void InitServerData(ServerData *serverData, Sim *sim);
+// Binds the sockets, opens a snapshot reader on every sim and starts the server
+// thread and workers; no sim may be running yet. New players join the first room
+// with a free slot. Returns false if the port can't be bound.
+bool StartServer(ServerData *serverData);
+// Wakes the server thread out of epoll_wait and waits for it to finish
+void StopServer(ServerData *serverData);
+
+void *ServerMode(void *args);
+
+#endif
@@ -0,0 +1,137 @@
+#include "server.h"
+#include "profiler.h"
+#include "record.h"
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DEFAULT_SERVER_PORT 7777
+// Independent matches one process can host, all on the same port
+#define MAX_ROOMS 256
+
+static void PrintUsage(const char *program) {
+    printf("Usage: %s [--port N] [--tick-rate N] [--max-players N] [--rooms N] [--workers N] [--profile-csv FILE] [--record FILE]\n"
+           "          [--telemetry FILE]\n", program);
+    printf("  --port         UDP port to listen on (default %d)\n", DEFAULT_SERVER_PORT);
+    printf("  --tick-rate    simulation ticks per second (default %d)\n", SIM_DEFAULT_TICK_RATE);
+    printf("  --max-players  player capacity of each room, at most %d (default %d)\n", NET_MAX_PLAYERS, MAX_CLIENTS);
+    printf("  --rooms        independent matches, at most %d; players fill them in order (default 1)\n", MAX_ROOMS);
+    printf("  --workers      threads ticking the rooms (default one per core)\n");
+    printf("  --profile-csv  write tick and network phase timings to FILE on shutdown\n");
+    printf("  --record       log every input and tick of the first room to FILE for floatyboaty-replay\n");
+    printf("  --telemetry    append each player's round trip, jitter, traffic and tick overruns to FILE every second;\n");
+    printf("                 past %d MB it moves to FILE.1, keeping %d old files\n", TELEMETRY_FILE_MAX_BYTES >> 20, TELEMETRY_FILE_KEEP);
+}
+
+static void FreeSims(Sim *sims, int count) {
+    for (int r = 0; r < count; r++) FreeSim(&sims[r]);
+    free(sims);
+}
+
+// Headless dedicated server: the simulation and the network loop without a window
+int main(int argc, char **argv) {
+    int port = DEFAULT_SERVER_PORT;
+    int tickRate = SIM_DEFAULT_TICK_RATE;
+    int maxPlayers = MAX_CLIENTS;
+    int roomCount = 1;
+    int workerCount = GetCoreCount();
+    const char *profilePath = NULL;
+    const char *recordPath = NULL;
+    const char *telemetryPath = NULL;
+
+    static const struct option options[] = {
+        {"port", required_argument, NULL, 'p'},
+        {"tick-rate", required_argument, NULL, 't'},
+        {"max-players", required_argument, NULL, 'm'},
+        {"rooms", required_argument, NULL, 'o'},
+        {"workers", required_argument, NULL, 'w'},
+        {"profile-csv", required_argument, NULL, 'c'},
+        {"record", required_argument, NULL, 'r'},
+        {"telemetry", required_argument, NULL, 'e'},
+        {"help", no_argument, NULL, 'h'},
+        {0}
+    };
+    int option;
+    while ((option = getopt_long(argc, argv, "p:t:m:o:w:c:r:e:h", options, NULL)) != -1) {
+        switch (option) {
+            case 'p': port = atoi(optarg); break;
+            case 't': tickRate = atoi(optarg); break;
+            case 'm': maxPlayers = atoi(optarg); break;
+            case 'o': roomCount = atoi(optarg); break;
+            case 'w': workerCount = atoi(optarg); break;
+            case 'c': profilePath = optarg; break;
+            case 'r': recordPath = optarg; break;
+            case 'e': telemetryPath = optarg; break;
+            case 'h': PrintUsage(argv[0]); return 0;
+            default: PrintUsage(argv[0]); return 1;
+        }
+    }
+    if (port <= 0 || port > 65535 || tickRate <= 0 || tickRate > 1000 || maxPlayers <= 0 || maxPlayers > NET_MAX_PLAYERS ||
+        roomCount <= 0 || roomCount > MAX_ROOMS || workerCount <= 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    // Every thread inherits the blocked signals, so only sigwait below sees them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    // The worker pool ticks the sims, none of them runs its own thread
+    Sim *sims = calloc(roomCount, sizeof(Sim));
+    ServerData serverData;
+    for (int r = 0; r < roomCount; r++) InitSim(&sims[r], tickRate, maxPlayers);
+    InitServerData(&serverData, sims);
+    serverData.roomCount = roomCount;
+    serverData.workerCount = workerCount;
+    serverData.serverPort = port;
+
+    static Recorder recorder;
+    if (recordPath) {
+        if (!OpenRecorder(&recorder, recordPath, tickRate, maxPlayers)) {
+            printf("Error: Could not write %s.\n", recordPath);
+            FreeSims(sims, roomCount);
+            return 1;
+        }
+        sims[0].recorder = &recorder;
+    }
+
+    static TelemetryLog telemetry;
+    if (telemetryPath) {
+        if (!OpenTelemetryLog(&telemetry, telemetryPath)) {
+            printf("Error: Could not write %s.\n", telemetryPath);
+            FreeSims(sims, roomCount);
+            CloseRecorder(&recorder);
+            return 1;
+        }
+        serverData.telemetry = &telemetry;
+    }
+
+    if (!StartServer(&serverData)) {
+        printf("Error: Could not listen on port %d.\n", port);
+        FreeSims(sims, roomCount);
+        CloseRecorder(&recorder);
+        CloseTelemetryLog(&telemetry);
+        return 1;
+    }
+    printf("Listening on port %d, %d ticks per second, %d rooms of %d players on %d workers\n",
+           port, tickRate, roomCount, maxPlayers, workerCount);
+    fflush(stdout);
+
+    int received;
+    sigwait(&signals, &received);
+    printf("Shutting down\n");
+
+    StopServer(&serverData);
+    FreeSims(sims, roomCount);
+    CloseRecorder(&recorder);
+    CloseTelemetryLog(&telemetry);
+    if (profilePath && !ExportProfileCsv(profilePath)) {
+        printf("Error: Could not write %s.\n", profilePath);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,370 @@
+#include "sim.h"
+#include "profiler.h"
+#include "record.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SNAPSHOT_FRESH 4
+
+// Ticks the loop may fall behind before it gives up catching up
+#define SIM_MAX_LAG_TICKS 5
+
+void InitTripleBuffer(TripleBuffer *buffer) {
+    buffer->front = 0;
+    atomic_init(&buffer->middle, 1);
+    buffer->back = 2;
+}
+
+void PublishTripleBuffer(TripleBuffer *buffer) {
+    int previous = atomic_exchange_explicit(&buffer->middle, buffer->back | SNAPSHOT_FRESH, memory_order_acq_rel);
+    buffer->back = previous & ~SNAPSHOT_FRESH;
+}
+
+bool AcquireTripleBuffer(TripleBuffer *buffer) {
+    if (!(atomic_load_explicit(&buffer->middle, memory_order_relaxed) & SNAPSHOT_FRESH)) return false;
+    int previous = atomic_exchange_explicit(&buffer->middle, buffer->front, memory_order_acq_rel);
+    buffer->front = previous & ~SNAPSHOT_FRESH;
+    return true;
+}
+
+static uint64_t NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void InitProjectilePool(ProjectilePool *pool, int capacity) {
+    memset(pool, 0, sizeof(*pool));
+    pool->capacity = capacity;
+    pool->position = malloc(capacity * sizeof(Vec3));
+    pool->direction = malloc(capacity * sizeof(Vec3));
+    pool->origin = malloc(capacity * sizeof(Vec3));
+    pool->launchTick = malloc(capacity * sizeof(uint32_t));
+    pool->owner = malloc(capacity * sizeof(int));
+    pool->id = malloc(capacity * sizeof(int));
+    pool->slotOf = malloc(capacity * sizeof(int));
+    pool->freeIds = malloc(capacity * sizeof(int));
+
+    // Low ids come out first
+    for (int i = 0; i < capacity; i++) {
+        pool->slotOf[i] = -1;
+        pool->freeIds[i] = capacity - 1 - i;
+    }
+    pool->freeCount = capacity;
+}
+
+void FreeProjectilePool(ProjectilePool *pool) {
+    free(pool->position);
+    free(pool->direction);
+    free(pool->origin);
+    free(pool->launchTick);
+    free(pool->owner);
+    free(pool->id);
+    free(pool->slotOf);
+    free(pool->freeIds);
+    memset(pool, 0, sizeof(*pool));
+}
+
+int SpawnProjectile(ProjectilePool *pool, int owner, Vec3 origin, Vec3 direction, uint32_t launchTick) {
+    if (pool->freeCount == 0) return -1;
+    int id = pool->freeIds[--pool->freeCount];
+    int slot = pool->count++;
+
+    pool->position[slot] = origin;
+    pool->direction[slot] = direction;
+    pool->origin[slot] = origin;
+    pool->launchTick[slot] = launchTick;
+    pool->owner[slot] = owner;
+    pool->id[slot] = id;
+    pool->slotOf[id] = slot;
+    return id;
+}
+
+void DespawnProjectile(ProjectilePool *pool, int id) {
+    int slot = pool->slotOf[id];
+    int last = --pool->count;
+
+    if (slot != last) {
+        pool->position[slot] = pool->position[last];
+        pool->direction[slot] = pool->direction[last];
+        pool->origin[slot] = pool->origin[last];
+        pool->launchTick[slot] = pool->launchTick[last];
+        pool->owner[slot] = pool->owner[last];
+        pool->id[slot] = pool->id[last];
+        pool->slotOf[pool->id[slot]] = slot;
+    }
+    pool->slotOf[id] = -1;
+    pool->freeIds[pool->freeCount++] = id;
+}
+
+void ClearProjectilePool(ProjectilePool *pool) {
+    for (int i = 0; i < pool->count; i++) {
+        pool->slotOf[pool->id[i]] = -1;
+        pool->freeIds[pool->freeCount++] = pool->id[i];
+    }
+    pool->count = 0;
+}
+
+void CopyProjectilePool(ProjectilePool *dst, const ProjectilePool *src) {
+    int n = src->count;
+    memcpy(dst->position, src->position, n * sizeof(Vec3));
+    memcpy(dst->direction, src->direction, n * sizeof(Vec3));
+    memcpy(dst->origin, src->origin, n * sizeof(Vec3));
+    memcpy(dst->launchTick, src->launchTick, n * sizeof(uint32_t));
+    memcpy(dst->owner, src->owner, n * sizeof(int));
+    memcpy(dst->id, src->id, n * sizeof(int));
+    dst->count = n;
+}
+
+void InitWorldSnapshot(WorldSnapshot *world, int playerCount) {
+    memset(world, 0, sizeof(*world));
+    world->playerCount = playerCount;
+    world->players = calloc(playerCount, sizeof(Player));
+    InitProjectilePool(&world->projectiles, playerCount * MAX_CANNONBALLS);
+}
+
+void FreeWorldSnapshot(WorldSnapshot *world) {
+    free(world->players);
+    FreeProjectilePool(&world->projectiles);
+    memset(world, 0, sizeof(*world));
+}
+
+void InitSim(Sim *sim, int tickRate, int maxPlayers) {
+    memset(sim, 0, sizeof(*sim));
+    sim->tickRate = (tickRate > 0) ? tickRate : SIM_DEFAULT_TICK_RATE;
+    sim->maxPlayers = (maxPlayers > 0) ? maxPlayers : MAX_CLIENTS;
+    atomic_init(&sim->running, false);
+
+    sim->players = calloc(sim->maxPlayers, sizeof(Player));
+    sim->connected = calloc(sim->maxPlayers, sizeof(bool));
+    sim->shotsSeen = calloc(sim->maxPlayers, sizeof(uint32_t));
+    sim->inputs = calloc(sim->maxPlayers, sizeof(InputMailbox));
+    InitProjectilePool(&sim->projectiles, sim->maxPlayers * MAX_CANNONBALLS);
+    InitCollisionGrid(&sim->collision, WATER_WIDTH, WATER_LENGTH, COLLISION_CELL_SIZE);
+
+    for (int i = 0; i < sim->maxPlayers; i++) {
+        sim->players[i].health = MAX_HEALTH;
+        InitTripleBuffer(&sim->inputs[i].buffer);
+    }
+    for (int r = 0; r < SIM_MAX_READERS; r++) {
+        InitTripleBuffer(&sim->snapshots[r].buffer);
+        for (int s = 0; s < 3; s++) InitWorldSnapshot(&sim->snapshots[r].slots[s], sim->maxPlayers);
+    }
+}
+
+void FreeSim(Sim *sim) {
+    StopSimThread(sim);
+    for (int r = 0; r < SIM_MAX_READERS; r++) {
+        for (int s = 0; s < 3; s++) FreeWorldSnapshot(&sim->snapshots[r].slots[s]);
+    }
+    free(sim->players);
+    free(sim->connected);
+    free(sim->shotsSeen);
+    free(sim->inputs);
+    FreeProjectilePool(&sim->projectiles);
+    FreeCollisionGrid(&sim->collision);
+    memset(sim, 0, sizeof(*sim));
+}
+
+int OpenSnapshotReader(Sim *sim) {
+    if (sim->readerCount >= SIM_MAX_READERS) return -1;
+    return sim->readerCount++;
+}
+
+void SubmitInput(Sim *sim, int playerId, const PlayerInput *input) {
+    InputMailbox *mailbox = &sim->inputs[playerId];
+    mailbox->slots[mailbox->buffer.back] = *input;
+    PublishTripleBuffer(&mailbox->buffer);
+}
+
+const WorldSnapshot *AcquireSnapshot(Sim *sim, int reader) {
+    SnapshotChannel *channel = &sim->snapshots[reader];
+    AcquireTripleBuffer(&channel->buffer);
+    return &channel->slots[channel->buffer.front];
+}
+
+static void ApplyInputs(Sim *sim) {
+    for (int i = 0; i < sim->maxPlayers; i++) {
+        InputMailbox *mailbox = &sim->inputs[i];
+        bool fresh = AcquireTripleBuffer(&mailbox->buffer);
+        const PlayerInput *input = &mailbox->slots[mailbox->buffer.front];
+        Player *player = &sim->players[i];
+        if (fresh && sim->recorder) RecordInput(sim->recorder, sim->tick, i, input);
+
+        // A new connection joins at full health; sunk players stay out until they rejoin
+        if (input->connected != sim->connected[i]) {
+            sim->connected[i] = input->connected;
+            player->active = input->connected;
+            player->health = MAX_HEALTH;
+            // A reused slot starts counting from the new connection's shots
+            sim->shotsSeen[i] = input->shots;
+        }
+        if (!player->active) {
+            sim->shotsSeen[i] = input->shots;
+            continue;
+        }
+
+        player->position.x = fminf(fmaxf(input->position.x, -WORLD_HALF_EXTENT), WORLD_HALF_EXTENT);
+        player->position.y = fminf(fmaxf(input->position.y, -WORLD_HALF_EXTENT), WORLD_HALF_EXTENT);
+        player->position.z = fminf(fmaxf(input->position.z, -WORLD_HALF_EXTENT), WORLD_HALF_EXTENT);
+
+        // Shots beyond MAX_CANNONBALLS in flight are dropped. A count that went backwards
+        // or jumped further than that can't be real shots, only a resync.
+        int32_t delta = (int32_t)(input->shots - sim->shotsSeen[i]);
+        sim->shotsSeen[i] = input->shots;
+        if (delta <= 0 || delta > MAX_CANNONBALLS) continue;
+        Vec3 muzzle = {player->position.x, player->position.y, player->position.z};
+        for (int shot = 0; shot < delta && player->cannonballCount < MAX_CANNONBALLS; shot++) {
+            if (SpawnProjectile(&sim->projectiles, i, muzzle, input->aim, sim->tick) < 0) break;
+            player->cannonballCount++;
+        }
+    }
+}
+
+static void RemoveCannonball(Sim *sim, int id) {
+    ProjectilePool *pool = &sim->projectiles;
+    sim->players[pool->owner[pool->slotOf[id]]].cannonballCount--;
+    DespawnProjectile(pool, id);
+}
+
+static void UpdateCannonballs(Sim *sim) {
+    ProjectilePool *pool = &sim->projectiles;
+    float step = CANNONBALL_SPEED * (1.0f / sim->tickRate);
+    // Backwards, so the projectile swapped into a removed slot was already moved this tick
+    for (int i = pool->count - 1; i >= 0; i--) {
+        Vec3 *position = &pool->position[i];
+        const Vec3 *direction = &pool->direction[i];
+        position->x += direction->x * step;
+        position->y += direction->y * step;
+        position->z += direction->z * step;
+        if (position->z < -WATER_LENGTH / 2 || position->z > WATER_LENGTH / 2 ||
+            position->x < -WATER_WIDTH / 2 || position->x > WATER_WIDTH / 2) {
+            RemoveCannonball(sim, pool->id[i]);
+        }
+    }
+}
+
+// Every player's cannonballs against every other boat
+static void CheckHits(Sim *sim) {
+    ProjectilePool *pool = &sim->projectiles;
+    if (pool->count == 0) return;
+
+    CollisionGrid *grid = &sim->collision;
+    ResetCollisionGrid(grid);
+    for (int i = 0; i < pool->count; i++) {
+        AddProjectile(grid, pool->position[i].x, pool->position[i].y, pool->position[i].z, pool->owner[i], pool->id[i]);
+    }
+    BuildCollisionGrid(grid);
+
+    for (int i = 0; i < sim->maxPlayers; i++) {
+        Player *target = &sim->players[i];
+        if (!target->active) continue;
+
+        // Cannonballs past the one that sinks the boat fly on
+        int hits[(MAX_HEALTH + CANNONBALL_DAMAGE - 1) / CANNONBALL_DAMAGE];
+        int maxHits = (target->health + CANNONBALL_DAMAGE - 1) / CANNONBALL_DAMAGE;
+        int count = CollideSphere(grid, target->position.x, target->position.y, target->position.z,
+                                  CANNONBALL_HIT_RADIUS, i, hits, maxHits);
+        for (int h = 0; h < count; h++) {
+            RemoveCannonball(sim, hits[h]);
+            target->health -= CANNONBALL_DAMAGE;
+        }
+        if (target->health <= 0) {
+            target->health = 0;
+            target->active = false;
+        }
+    }
+}
+
+static void RegenerateHealth(Sim *sim) {
+    // Health is whole points, so each second's HEALTH_REGEN is spread over its ticks
+    uint64_t tick = sim->tick;
+    int regen = (int)((tick + 1) * HEALTH_REGEN / sim->tickRate - tick * HEALTH_REGEN / sim->tickRate);
+    if (regen == 0) return;
+    for (int i = 0; i < sim->maxPlayers; i++) {
+        Player *player = &sim->players[i];
+        if (player->active && player->health < MAX_HEALTH) {
+            player->health += regen;
+            if (player->health > MAX_HEALTH) player->health = MAX_HEALTH;
+        }
+    }
+}
+
+static void PublishSnapshots(Sim *sim) {
+    for (int r = 0; r < sim->readerCount; r++) {
+        SnapshotChannel *channel = &sim->snapshots[r];
+        WorldSnapshot *snapshot = &channel->slots[channel->buffer.back];
+        snapshot->tick = sim->tick;
+        snapshot->tickNs = sim->lastTickNs;
+        snapshot->overruns = sim->overruns;
+        memcpy(snapshot->players, sim->players, sim->maxPlayers * sizeof(Player));
+        CopyProjectilePool(&snapshot->projectiles, &sim->projectiles);
+        PublishTripleBuffer(&channel->buffer);
+    }
+}
+
+void StepSim(Sim *sim) {
+    uint64_t start = NowNs();
+    PROFILE_SCOPE(PHASE_TICK);
+
+    PROFILE_BEGIN(PHASE_TICK_INPUTS);
+    ApplyInputs(sim);
+    PROFILE_END(PHASE_TICK_INPUTS);
+    PROFILE_BEGIN(PHASE_TICK_CANNONBALLS);
+    UpdateCannonballs(sim);
+    PROFILE_END(PHASE_TICK_CANNONBALLS);
+    PROFILE_BEGIN(PHASE_TICK_HITS);
+    CheckHits(sim);
+    PROFILE_END(PHASE_TICK_HITS);
+    RegenerateHealth(sim);
+    sim->tick++;
+
+    sim->lastTickNs = NowNs() - start;
+    PROFILE_BEGIN(PHASE_TICK_PUBLISH);
+    PublishSnapshots(sim);
+    PROFILE_END(PHASE_TICK_PUBLISH);
+
+    if (sim->recorder) {
+        WorldSnapshot world = {
+            .tick = sim->tick, .tickNs = sim->lastTickNs, .overruns = sim->overruns,
+            .playerCount = sim->maxPlayers, .players = sim->players, .projectiles = sim->projectiles
+        };
+        RecordWorld(sim->recorder, &world);
+    }
+}
+
+static void *SimThread(void *args) {
+    Sim *sim = (Sim *)args;
+    uint64_t period = 1000000000ull / (uint64_t)sim->tickRate;
+    uint64_t next = NowNs();
+
+    while (atomic_load_explicit(&sim->running, memory_order_relaxed)) {
+        StepSim(sim);
+
+        next += period;
+        uint64_t now = NowNs();
+        if (now > next) {
+            sim->overruns++;
+            // Too far behind to catch up without a burst of ticks, start over from now
+            if (now - next > period * SIM_MAX_LAG_TICKS) next = now;
+            continue;
+        }
+
+        struct timespec wake = {.tv_sec = (time_t)(next / 1000000000ull), .tv_nsec = (long)(next % 1000000000ull)};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL);
+    }
+
+    return NULL;
+}
+
+void StartSimThread(Sim *sim) {
+    atomic_store(&sim->running, true);
+    pthread_create(&sim->thread, NULL, SimThread, sim);
+}
+
+void StopSimThread(Sim *sim) {
+    if (!atomic_exchange(&sim->running, false)) return;
+    pthread_join(sim->thread, NULL);
+}
@@ -0,0 +1,158 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include "collision.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Default player capacity of a hosted game; servers can ask for more
+#define MAX_CLIENTS 10
+#define MAX_CANNONBALLS 50
+#define MAX_HEALTH 100
+#define CANNONBALL_DAMAGE 20
+#define CANNONBALL_SPEED 12.0f       // units per second
+#define CANNONBALL_HIT_RADIUS 1.0f
+#define HEALTH_REGEN 60              // health per second
+
+// Size of the water plane, cannonballs die at its edge
+#define WATER_WIDTH 400.0f
+#define WATER_LENGTH 400.0f
+// Boats stay within this distance of the origin on every axis. The ocean is drawn
+// past it, but the network position encoding only reaches this far.
+#define WORLD_HALF_EXTENT 500.0f
+
+// Rates above are per second; the sim scales them by its tick rate
+#define SIM_DEFAULT_TICK_RATE 60
+#define SIM_MAX_READERS 4
+
+typedef struct {
+    float x, y, z;
+} Vec3;
+
+typedef struct {
+    float x, y, z;
+} BoatPosition;
+
+// Every cannonball in flight, structure-of-arrays. Live projectiles fill the
+// dense range [0, count) so loops never visit dead ones; ids stay stable while
+// a projectile lives and are recycled through a free list afterwards.
+typedef struct {
+    int capacity;
+    int count;
+    // Dense, by slot
+    Vec3 *position;
+    Vec3 *direction;
+    Vec3 *origin;          // where and when it was fired, enough to replay its flight
+    uint32_t *launchTick;
+    int *owner;
+    int *id;
+    // By id
+    int *slotOf;           // dense slot, -1 when free
+    int *freeIds;          // stack of unused ids
+    int freeCount;
+} ProjectilePool;
+
+typedef struct {
+    BoatPosition position;
+    int health;
+    bool active;
+    int cannonballCount;   // in flight, at most MAX_CANNONBALLS
+} Player;
+
+// What a player's owner tells the simulation, only the latest one matters
+typedef struct {
+    bool connected;
+    BoatPosition position;
+    Vec3 aim;              // direction new cannonballs fly in
+    uint32_t shots;        // running count of shots fired, never reset
+} PlayerInput;
+
+// Immutable view of the world published once per tick
+typedef struct {
+    uint32_t tick;
+    uint64_t tickNs;       // how long StepSim took for this tick
+    uint32_t overruns;     // ticks that started late since the sim started
+    int playerCount;       // player capacity, active or not
+    Player *players;
+    ProjectilePool projectiles;
+} WorldSnapshot;
+
+// Lock-free single-producer/single-consumer handoff of the latest value.
+// The producer fills slot `back` and publishes, the consumer acquires and
+// reads slot `front`; the three slots are never shared between threads.
+typedef struct {
+    _Atomic int middle;    // slot index, SNAPSHOT_FRESH set when not yet acquired
+    int back;
+    int front;
+} TripleBuffer;
+
+typedef struct {
+    TripleBuffer buffer;
+    PlayerInput slots[3];
+} InputMailbox;
+
+typedef struct {
+    TripleBuffer buffer;
+    WorldSnapshot slots[3];
+} SnapshotChannel;
+
+typedef struct {
+    int tickRate;
+    int maxPlayers;
+    atomic_bool running;
+    pthread_t thread;
+
+    // Owned by the simulation thread
+    uint32_t tick;
+    uint32_t overruns;
+    uint64_t lastTickNs;
+    Player *players;
+    ProjectilePool projectiles;
+    bool *connected;
+    uint32_t *shotsSeen;
+
+    CollisionGrid collision;
+
+    InputMailbox *inputs;
+    SnapshotChannel snapshots[SIM_MAX_READERS];
+    int readerCount;
+
+    struct Recorder *recorder;     // optional, set before StartSimThread to log the match
+} Sim;
+
+void InitTripleBuffer(TripleBuffer *buffer);
+void PublishTripleBuffer(TripleBuffer *buffer);
+bool AcquireTripleBuffer(TripleBuffer *buffer);
+
+void InitProjectilePool(ProjectilePool *pool, int capacity);
+void FreeProjectilePool(ProjectilePool *pool);
+// O(1); returns the new projectile's id, or -1 when the pool is full
+int SpawnProjectile(ProjectilePool *pool, int owner, Vec3 origin, Vec3 direction, uint32_t launchTick);
+// O(1); the last live projectile moves into the freed slot
+void DespawnProjectile(ProjectilePool *pool, int id);
+// Frees every live projectile, O(count)
+void ClearProjectilePool(ProjectilePool *pool);
+// Copies the live range; `dst` must have the same capacity
+void CopyProjectilePool(ProjectilePool *dst, const ProjectilePool *src);
+
+void InitWorldSnapshot(WorldSnapshot *world, int playerCount);
+void FreeWorldSnapshot(WorldSnapshot *world);
+
+void InitSim(Sim *sim, int tickRate, int maxPlayers);
+void FreeSim(Sim *sim);
+// Readers must be opened before StartSimThread; returns -1 when all are taken
+int OpenSnapshotReader(Sim *sim);
+void StartSimThread(Sim *sim);
+void StopSimThread(Sim *sim);
+
+// One writer per player id; the sim picks the input up on its next tick
+void SubmitInput(Sim *sim, int playerId, const PlayerInput *input);
+// Never blocks; returns the newest snapshot published for this reader
+const WorldSnapshot *AcquireSnapshot(Sim *sim, int reader);
+
+// Advances the world by one tick and publishes it to every reader
+void StepSim(Sim *sim);
+
+#endif
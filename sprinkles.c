@@ -0,0 +1,199 @@
+#include "sprinkles.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include <string.h>
+
+static const char *sprinkleVertexShader =
+    "#version 330\n"
+    "in vec3 vertexPosition;\n"
+    "in vec3 instanceOffset;\n"
+    "in float instanceHeight;\n"
+    "uniform mat4 mvp;\n"
+    "void main() {\n"
+    "    gl_Position = mvp*vec4(vertexPosition + instanceOffset + vec3(0.0, instanceHeight, 0.0), 1.0);\n"
+    "}\n";
+
+static const char *sprinkleFragmentShader =
+    "#version 330\n"
+    "uniform vec4 colDiffuse;\n"
+    "out vec4 finalColor;\n"
+    "void main() {\n"
+    "    finalColor = colDiffuse;\n"
+    "}\n";
+
+static const unsigned short cubeIndices[36] = {
+    0, 1, 2, 0, 2, 3,   // front
+    5, 4, 7, 5, 7, 6,   // back
+    4, 0, 3, 4, 3, 7,   // left
+    1, 5, 6, 1, 6, 2,   // right
+    3, 2, 6, 3, 6, 7,   // top
+    4, 5, 1, 4, 1, 0    // bottom
+};
+
+// Writes the 8 corners of a sprinkle cube centered on `center`
+static void WriteCubeCorners(float *out, Vector3 center) {
+    float hx = SPRINKLE_WIDTH / 2, hy = SPRINKLE_HEIGHT / 2, hz = SPRINKLE_LENGTH / 2;
+    const float corners[8][3] = {
+        {-hx, -hy,  hz}, { hx, -hy,  hz}, { hx,  hy,  hz}, {-hx,  hy,  hz},
+        {-hx, -hy, -hz}, { hx, -hy, -hz}, { hx,  hy, -hz}, {-hx,  hy, -hz}
+    };
+    for (int i = 0; i < 8; i++) {
+        out[i * 3 + 0] = center.x + corners[i][0];
+        out[i * 3 + 1] = center.y + corners[i][1];
+        out[i * 3 + 2] = center.z + corners[i][2];
+    }
+}
+
+static bool LoadInstancedPath(SprinkleRenderer *renderer) {
+    if (rlGetVersion() != RL_OPENGL_33 && rlGetVersion() != RL_OPENGL_43) return false;
+
+    Shader shader = LoadShaderFromMemory(sprinkleVertexShader, sprinkleFragmentShader);
+    int positionLoc = GetShaderLocationAttrib(shader, "vertexPosition");
+    int offsetLoc = GetShaderLocationAttrib(shader, "instanceOffset");
+    int heightLoc = GetShaderLocationAttrib(shader, "instanceHeight");
+    if (shader.id == rlGetShaderIdDefault() || positionLoc < 0 || offsetLoc < 0 || heightLoc < 0) {
+        UnloadShader(shader);
+        return false;
+    }
+
+    unsigned int vaoId = rlLoadVertexArray();
+    if (vaoId == 0) {
+        UnloadShader(shader);
+        return false;
+    }
+
+    float corners[8 * 3];
+    WriteCubeCorners(corners, (Vector3){0.0f, 0.0f, 0.0f});
+
+    rlEnableVertexArray(vaoId);
+    renderer->vertexVboId = rlLoadVertexBuffer(corners, sizeof(corners), false);
+    rlSetVertexAttribute(positionLoc, 3, RL_FLOAT, false, 0, 0);
+    rlEnableVertexAttribute(positionLoc);
+    renderer->indexVboId = rlLoadVertexBufferElement(cubeIndices, sizeof(cubeIndices), false);
+
+    // Batches come and go; the instance attributes are pointed at a batch's buffers at draw time
+    rlSetVertexAttributeDivisor(offsetLoc, 1);
+    rlEnableVertexAttribute(offsetLoc);
+    rlSetVertexAttributeDivisor(heightLoc, 1);
+    rlEnableVertexAttribute(heightLoc);
+    rlDisableVertexArray();
+
+    renderer->shader = shader;
+    renderer->mvpLoc = GetShaderLocation(shader, "mvp");
+    renderer->colorLoc = GetShaderLocation(shader, "colDiffuse");
+    renderer->offsetLoc = offsetLoc;
+    renderer->heightLoc = heightLoc;
+    renderer->vaoId = vaoId;
+    return true;
+}
+
+void LoadSprinkleRenderer(SprinkleRenderer *renderer) {
+    memset(renderer, 0, sizeof(*renderer));
+    renderer->instanced = LoadInstancedPath(renderer);
+    if (!renderer->instanced) {
+        TraceLog(LOG_INFO, "SPRINKLES: Instancing not available, using merged meshes");
+        renderer->material = LoadMaterialDefault();
+    }
+}
+
+void UnloadSprinkleRenderer(SprinkleRenderer *renderer) {
+    if (renderer->instanced) {
+        rlUnloadVertexArray(renderer->vaoId);
+        rlUnloadVertexBuffer(renderer->vertexVboId);
+        rlUnloadVertexBuffer(renderer->indexVboId);
+        UnloadShader(renderer->shader);
+    } else {
+        UnloadMaterial(renderer->material);
+    }
+    memset(renderer, 0, sizeof(*renderer));
+}
+
+void LoadSprinkleBatch(const SprinkleRenderer *renderer, SprinkleBatch *batch, const Vector3 *positions, int count) {
+    memset(batch, 0, sizeof(*batch));
+    if (count > SPRINKLES_PER_BATCH) count = SPRINKLES_PER_BATCH;
+    batch->count = count;
+    if (count <= 0) return;
+
+    if (renderer->instanced) {
+        batch->instanceVboId = rlLoadVertexBuffer(positions, count * (int)sizeof(Vector3), false);
+        // Calm water until the first UpdateSprinkleHeights
+        float *heights = MemAlloc(count * sizeof(float));
+        batch->heightVboId = rlLoadVertexBuffer(heights, count * (int)sizeof(float), true);
+        MemFree(heights);
+        return;
+    }
+
+    Mesh mesh = { 0 };
+    mesh.vertexCount = count * 8;
+    mesh.triangleCount = count * 12;
+    mesh.vertices = MemAlloc(mesh.vertexCount * 3 * sizeof(float));
+    mesh.indices = MemAlloc(mesh.triangleCount * 3 * sizeof(unsigned short));
+    for (int i = 0; i < count; i++) {
+        WriteCubeCorners(&mesh.vertices[i * 8 * 3], positions[i]);
+        for (int j = 0; j < 36; j++) {
+            mesh.indices[i * 36 + j] = (unsigned short)(i * 8 + cubeIndices[j]);
+        }
+    }
+    UploadMesh(&mesh, false);
+    batch->mesh = mesh;
+}
+
+void UnloadSprinkleBatch(const SprinkleRenderer *renderer, SprinkleBatch *batch) {
+    if (batch->count > 0) {
+        if (renderer->instanced) {
+            rlUnloadVertexBuffer(batch->instanceVboId);
+            rlUnloadVertexBuffer(batch->heightVboId);
+        } else {
+            UnloadMesh(batch->mesh);
+        }
+    }
+    memset(batch, 0, sizeof(*batch));
+}
+
+void UpdateSprinkleHeights(const SprinkleRenderer *renderer, const SprinkleBatch *batch, const float *heights, int count) {
+    if (count > batch->count) count = batch->count;
+    if (!renderer->instanced || count <= 0) return;
+    rlUpdateVertexBuffer(batch->heightVboId, heights, count * (int)sizeof(float), 0);
+}
+
+void BeginSprinkles(SprinkleRenderer *renderer, Color color) {
+    renderer->color = color;
+    if (!renderer->instanced) return;
+
+    // Flush queued immediate-mode geometry so it keeps its draw order
+    rlDrawRenderBatchActive();
+
+    float diffuse[4] = { color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f };
+    Matrix mvp = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+
+    rlEnableShader(renderer->shader.id);
+    rlSetUniformMatrix(renderer->mvpLoc, mvp);
+    rlSetUniform(renderer->colorLoc, diffuse, RL_SHADER_UNIFORM_VEC4, 1);
+    rlEnableVertexArray(renderer->vaoId);
+}
+
+void DrawSprinkleBatch(const SprinkleRenderer *renderer, const SprinkleBatch *batch, int count) {
+    if (count > batch->count) count = batch->count;
+    if (count <= 0) return;
+
+    if (!renderer->instanced) {
+        Material material = renderer->material;
+        material.maps[MATERIAL_MAP_DIFFUSE].color = renderer->color;
+        // Cubes are merged in order, so the first count of them are the first count * 12 triangles
+        Mesh mesh = batch->mesh;
+        mesh.triangleCount = count * 12;
+        DrawMesh(mesh, material, MatrixIdentity());
+        return;
+    }
+    rlEnableVertexBuffer(batch->instanceVboId);
+    rlSetVertexAttribute(renderer->offsetLoc, 3, RL_FLOAT, false, 0, 0);
+    rlEnableVertexBuffer(batch->heightVboId);
+    rlSetVertexAttribute(renderer->heightLoc, 1, RL_FLOAT, false, 0, 0);
+    rlDrawVertexArrayElementsInstanced(0, 36, 0, count);
+}
+
+void EndSprinkles(const SprinkleRenderer *renderer) {
+    if (!renderer->instanced) return;
+    rlDisableVertexArray();
+    rlDisableShader();
+}
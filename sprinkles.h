@@ -0,0 +1,57 @@
+#ifndef SPRINKLES_H
+#define SPRINKLES_H
+
+#include "raylib.h"
+#include "cull.h"
+
+// Sprinkle cube dimensions, same as the old per-sprinkle DrawCube call
+#define SPRINKLE_WIDTH 0.5f
+#define SPRINKLE_HEIGHT 0.05f
+#define SPRINKLE_LENGTH 0.2f
+
+// Cubes per batch, 8 vertices each keeps the merged fallback mesh within 16-bit indices
+#define SPRINKLES_PER_BATCH 8192
+
+// A group of sprinkles uploaded together and drawn with one call
+typedef struct {
+    int count;
+    unsigned int instanceVboId;   // instanced path: static per-instance offsets
+    unsigned int heightVboId;     // instanced path: per-instance wave height, rewritten every frame
+    Mesh mesh;                    // fallback path: every cube merged into one mesh
+} SprinkleBatch;
+
+typedef struct {
+    bool instanced;        // true when each batch goes out in one instanced draw
+    Color color;           // set by BeginSprinkles
+
+    // Instanced path: one cube mesh shared by every batch
+    Shader shader;
+    int mvpLoc;
+    int colorLoc;
+    int offsetLoc;
+    int heightLoc;
+    unsigned int vaoId;
+    unsigned int vertexVboId;
+    unsigned int indexVboId;
+
+    // Fallback path: batches are pre-merged meshes drawn with this material
+    Material material;
+} SprinkleRenderer;
+
+void LoadSprinkleRenderer(SprinkleRenderer *renderer);
+void UnloadSprinkleRenderer(SprinkleRenderer *renderer);
+
+// Uploads up to SPRINKLES_PER_BATCH positions once; they are not kept on the CPU
+void LoadSprinkleBatch(const SprinkleRenderer *renderer, SprinkleBatch *batch, const Vector3 *positions, int count);
+void UnloadSprinkleBatch(const SprinkleRenderer *renderer, SprinkleBatch *batch);
+// Raises the first count sprinkles of the batch by heights[i] until the next update; the
+// merged meshes of the fallback path are static and stay at their loaded height
+void UpdateSprinkleHeights(const SprinkleRenderer *renderer, const SprinkleBatch *batch, const float *heights, int count);
+
+// Draw batches between BeginSprinkles and EndSprinkles
+void BeginSprinkles(SprinkleRenderer *renderer, Color color);
+// Draws the first count sprinkles of the batch
+void DrawSprinkleBatch(const SprinkleRenderer *renderer, const SprinkleBatch *batch, int count);
+void EndSprinkles(const SprinkleRenderer *renderer);
+
+#endif
@@ -0,0 +1,165 @@
+#include "telemetry.h"
+#include <math.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+
+// Smoothing gains of the round trip and its jitter, the ones TCP and RTP use
+#define RTT_GAIN (1.0f / 8.0f)
+#define JITTER_GAIN (1.0f / 16.0f)
+#define LOSS_GAIN (1.0f / 8.0f)
+
+static const char *logHeader =
+    "time_ms,room,player,peer,rtt_us,jitter_us,ping_loss,sent_bytes_per_s,received_bytes_per_s,"
+    "sent_messages_per_s,received_messages_per_s,dropped,send_queue_bytes,tick_us,overruns\n";
+
+void InitLinkTelemetry(LinkTelemetry *link, int64_t nowMs) {
+    atomic_store_explicit(&link->counters.bytesSent, 0, memory_order_relaxed);
+    atomic_store_explicit(&link->counters.bytesReceived, 0, memory_order_relaxed);
+    atomic_store_explicit(&link->counters.messagesSent, 0, memory_order_relaxed);
+    atomic_store_explicit(&link->counters.messagesReceived, 0, memory_order_relaxed);
+    atomic_store_explicit(&link->counters.messagesDropped, 0, memory_order_relaxed);
+    link->pingSequence = 0;
+    link->pingAnswered = false;
+    link->lastPingMs = nowMs;
+    link->hasRtt = false;
+    link->rttUs = link->lastRttUs = link->jitterUs = link->pingLoss = 0.0f;
+    link->windowStartMs = nowMs;
+    link->windowBytesSent = link->windowBytesReceived = 0;
+    link->windowMessagesSent = link->windowMessagesReceived = link->windowMessagesDropped = 0;
+}
+
+void CountSent(LinkCounters *counters, int bytes) {
+    atomic_fetch_add_explicit(&counters->bytesSent, bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->messagesSent, 1, memory_order_relaxed);
+}
+
+void CountReceived(LinkCounters *counters, int bytes) {
+    atomic_fetch_add_explicit(&counters->bytesReceived, bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->messagesReceived, 1, memory_order_relaxed);
+}
+
+void CountDropped(LinkCounters *counters) {
+    atomic_fetch_add_explicit(&counters->messagesDropped, 1, memory_order_relaxed);
+}
+
+uint32_t GetTelemetryClockUs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+bool NextPing(LinkTelemetry *link, int64_t nowMs, uint32_t *sequence) {
+    if (nowMs - link->lastPingMs < TELEMETRY_PING_INTERVAL_MS) return false;
+    if (link->pingSequence != 0 && !link->pingAnswered) link->pingLoss += (1.0f - link->pingLoss) * LOSS_GAIN;
+
+    // 0 means no ping yet
+    if (++link->pingSequence == 0) link->pingSequence = 1;
+    link->pingAnswered = false;
+    link->lastPingMs = nowMs;
+    *sequence = link->pingSequence;
+    return true;
+}
+
+void ReceivePong(LinkTelemetry *link, uint32_t sequence, uint32_t rttUs) {
+    if (sequence != link->pingSequence || link->pingAnswered) return;
+    link->pingAnswered = true;
+    link->pingLoss -= link->pingLoss * LOSS_GAIN;
+
+    float sample = (float)rttUs;
+    if (!link->hasRtt) {
+        link->rttUs = sample;
+        link->jitterUs = 0.0f;
+        link->hasRtt = true;
+    } else {
+        link->rttUs += (sample - link->rttUs) * RTT_GAIN;
+        link->jitterUs += (fabsf(sample - link->lastRttUs) - link->jitterUs) * JITTER_GAIN;
+    }
+    link->lastRttUs = sample;
+}
+
+bool CloseLinkWindow(LinkTelemetry *link, int64_t nowMs, LinkStats *stats) {
+    int64_t elapsedMs = nowMs - link->windowStartMs;
+    if (elapsedMs < TELEMETRY_WINDOW_MS) return false;
+
+    uint64_t bytesSent = atomic_load_explicit(&link->counters.bytesSent, memory_order_relaxed);
+    uint64_t bytesReceived = atomic_load_explicit(&link->counters.bytesReceived, memory_order_relaxed);
+    uint64_t messagesSent = atomic_load_explicit(&link->counters.messagesSent, memory_order_relaxed);
+    uint64_t messagesReceived = atomic_load_explicit(&link->counters.messagesReceived, memory_order_relaxed);
+    uint64_t messagesDropped = atomic_load_explicit(&link->counters.messagesDropped, memory_order_relaxed);
+    float perSecond = 1000.0f / elapsedMs;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->bytesSentPerSecond = (bytesSent - link->windowBytesSent) * perSecond;
+    stats->bytesReceivedPerSecond = (bytesReceived - link->windowBytesReceived) * perSecond;
+    stats->messagesSentPerSecond = (messagesSent - link->windowMessagesSent) * perSecond;
+    stats->messagesReceivedPerSecond = (messagesReceived - link->windowMessagesReceived) * perSecond;
+    stats->messagesDropped = (uint32_t)(messagesDropped - link->windowMessagesDropped);
+    stats->rttUs = (uint32_t)link->rttUs;
+    stats->jitterUs = (uint32_t)link->jitterUs;
+    stats->pingLoss = link->pingLoss;
+
+    link->windowStartMs = nowMs;
+    link->windowBytesSent = bytesSent;
+    link->windowBytesReceived = bytesReceived;
+    link->windowMessagesSent = messagesSent;
+    link->windowMessagesReceived = messagesReceived;
+    link->windowMessagesDropped = messagesDropped;
+    return true;
+}
+
+int GetSendQueueBytes(int fd) {
+    int bytes = 0;
+    if (ioctl(fd, TIOCOUTQ, &bytes) < 0) return 0;
+    return bytes;
+}
+
+bool OpenTelemetryLog(TelemetryLog *log, const char *path) {
+    memset(log, 0, sizeof(*log));
+    snprintf(log->path, sizeof(log->path), "%s", path);
+    log->file = fopen(path, "a");
+    if (!log->file) return false;
+    log->size = ftell(log->file);
+    if (log->size == 0) log->size += fprintf(log->file, "%s", logHeader);
+    return true;
+}
+
+void CloseTelemetryLog(TelemetryLog *log) {
+    if (log->file) fclose(log->file);
+    log->file = NULL;
+}
+
+void FlushTelemetryLog(TelemetryLog *log) {
+    if (log->file) fflush(log->file);
+}
+
+// Shifts FILE.1 .. FILE.(KEEP-1) up by one, dropping the oldest, and starts FILE over
+static void RotateTelemetryLog(TelemetryLog *log) {
+    fclose(log->file);
+    char from[sizeof(log->path) + 8], to[sizeof(log->path) + 8];
+    for (int i = TELEMETRY_FILE_KEEP - 1; i >= 1; i--) {
+        snprintf(from, sizeof(from), "%s.%d", log->path, i);
+        snprintf(to, sizeof(to), "%s.%d", log->path, i + 1);
+        rename(from, to);
+    }
+    snprintf(to, sizeof(to), "%s.1", log->path);
+    rename(log->path, to);
+
+    log->file = fopen(log->path, "w");
+    log->size = log->file ? fprintf(log->file, "%s", logHeader) : 0;
+}
+
+void WriteLinkStats(TelemetryLog *log, int room, int player, const char *peer, const LinkStats *stats) {
+    if (!log->file) return;
+    // Wall clock time, so rows can be matched with when a player says the game felt off
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    long long timeMs = (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+
+    int written = fprintf(log->file, "%lld,%d,%d,%s,%u,%u,%.3f,%.0f,%.0f,%.1f,%.1f,%u,%d,%u,%u\n", timeMs, room, player, peer,
+                          stats->rttUs, stats->jitterUs, stats->pingLoss, stats->bytesSentPerSecond,
+                          stats->bytesReceivedPerSecond, stats->messagesSentPerSecond, stats->messagesReceivedPerSecond,
+                          stats->messagesDropped, stats->sendQueueBytes, stats->tickUs, stats->overruns);
+    if (written > 0) log->size += written;
+    if (log->size > TELEMETRY_FILE_MAX_BYTES) RotateTelemetryLog(log);
+}
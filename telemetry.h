@@ -0,0 +1,96 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "sim.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Each side pings the other this often; a ping still unanswered when the next one
+// goes out counts as lost
+#define TELEMETRY_PING_INTERVAL_MS 500
+// Rates are averaged over this long, and the stats file gets a row per connection as often
+#define TELEMETRY_WINDOW_MS 1000
+// Past this size the stats file moves to FILE.1, FILE.1 to FILE.2 and so on, keeping this many
+#define TELEMETRY_FILE_MAX_BYTES (8 << 20)
+#define TELEMETRY_FILE_KEEP 3
+
+// Running totals of one connection. Several threads can bump the same counter: on the
+// server, the server thread counts its pings and the room workers count snapshots.
+typedef struct {
+    _Atomic uint64_t bytesSent;
+    _Atomic uint64_t bytesReceived;
+    _Atomic uint64_t messagesSent;
+    _Atomic uint64_t messagesReceived;
+    _Atomic uint64_t messagesDropped;  // never sent because the socket's send buffer was full
+} LinkCounters;
+
+// One window of one connection, as shown in the HUD and written to the stats file
+typedef struct {
+    float bytesSentPerSecond;
+    float bytesReceivedPerSecond;
+    float messagesSentPerSecond;
+    float messagesReceivedPerSecond;
+    uint32_t messagesDropped;  // during the window
+    uint32_t rttUs;            // smoothed round trip
+    uint32_t jitterUs;         // smoothed difference between successive round trips
+    float pingLoss;            // smoothed share of pings not answered in time
+    int sendQueueBytes;        // waiting in the socket's send buffer when the window closed
+    uint32_t tickUs;           // server step time and running overrun count of the match
+    uint32_t overruns;
+} LinkStats;
+
+// Counters plus the ping and window state, which belong to the thread that pings
+typedef struct {
+    LinkCounters counters;
+    uint32_t pingSequence;     // last ping sent, 0 before the first
+    bool pingAnswered;
+    int64_t lastPingMs;
+    bool hasRtt;
+    float rttUs, lastRttUs, jitterUs, pingLoss;
+    int64_t windowStartMs;
+    uint64_t windowBytesSent, windowBytesReceived;     // totals when the window opened
+    uint64_t windowMessagesSent, windowMessagesReceived, windowMessagesDropped;
+} LinkTelemetry;
+
+// Latest closed window, from the network thread to the renderer
+typedef struct {
+    TripleBuffer buffer;
+    LinkStats slots[3];
+} StatsMailbox;
+
+// Rotating CSV of LinkStats rows
+typedef struct {
+    char path[256];
+    FILE *file;
+    long size;
+} TelemetryLog;
+
+// Resets everything; the counters may still be counted into by another thread
+void InitLinkTelemetry(LinkTelemetry *link, int64_t nowMs);
+void CountSent(LinkCounters *counters, int bytes);
+void CountReceived(LinkCounters *counters, int bytes);
+void CountDropped(LinkCounters *counters);
+
+// Ping timestamps: microseconds, wrapping every 71 minutes, which round trips never come near
+uint32_t GetTelemetryClockUs(void);
+// True when a ping is due, with the sequence number to send it under
+bool NextPing(LinkTelemetry *link, int64_t nowMs, uint32_t *sequence);
+// Takes the round trip of an answered ping; answers to older pings are ignored
+void ReceivePong(LinkTelemetry *link, uint32_t sequence, uint32_t rttUs);
+// Once TELEMETRY_WINDOW_MS has passed, fills the rates and ping figures of the window
+// and opens the next one; the caller adds the queue and server fields
+bool CloseLinkWindow(LinkTelemetry *link, int64_t nowMs, LinkStats *stats);
+// Bytes in fd's send buffer not yet sent, 0 if the kernel can't say
+int GetSendQueueBytes(int fd);
+
+// Appends to path, starting it with a header row when it is new
+bool OpenTelemetryLog(TelemetryLog *log, const char *path);
+void CloseTelemetryLog(TelemetryLog *log);
+// Rows are buffered; this hands whatever is waiting to the file
+void FlushTelemetryLog(TelemetryLog *log);
+// room is -1 on the client, which doesn't know it; peer is the other end's address
+void WriteLinkStats(TelemetryLog *log, int room, int player, const char *peer, const LinkStats *stats);
+
+#endif
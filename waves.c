@@ -0,0 +1,131 @@
+#include "waves.h"
+#include <math.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+typedef struct {
+    float kx, kz;          // direction times wave number, radians per unit
+    float amplitude;
+    float omega;           // radians per second
+} Wave;
+
+// A long swell and two shorter chops across it, amplitudes add up to WAVE_MAX_HEIGHT
+#define WAVE(dirX, dirZ, wavelength, amplitude, period) \
+    {(dirX) * 6.2831853f / (wavelength), (dirZ) * 6.2831853f / (wavelength), amplitude, 6.2831853f / (period)}
+static const Wave waves[WAVE_COUNT] = {
+    WAVE(1.0f, 0.0f, 40.0f, 0.25f, 7.0f),
+    WAVE(0.6f, 0.8f, 23.0f, 0.15f, 4.5f),
+    WAVE(-0.7071f, 0.7071f, 11.0f, 0.06f, 2.9f)
+};
+
+// Cody-Waite split of 2 pi: the first part has few enough bits that k * part is exact
+#define TWO_PI_HIGH 6.28125f
+#define TWO_PI_LOW 1.9353071795864769e-3f
+#define INV_TWO_PI 0.15915494f
+#define PI_F 3.14159265f
+// Taylor terms up to x^7, accurate to about 1e-5 on [-pi/2, pi/2]
+#define SIN_C3 (-1.0f / 6.0f)
+#define SIN_C5 (1.0f / 120.0f)
+#define SIN_C7 (-1.0f / 5040.0f)
+
+WaveClock GetWaveClock(double seconds) {
+    WaveClock clock;
+    for (int w = 0; w < WAVE_COUNT; w++) clock.phases[w] = (float)fmod(waves[w].omega * seconds, 6.283185307179586);
+    return clock;
+}
+
+// Every kernel below does these same steps in the same order, lane by lane
+static float FastSin(float x) {
+    float k = rintf(x * INV_TWO_PI);
+    float r = (x - k * TWO_PI_HIGH) - k * TWO_PI_LOW;
+    // sin(pi - r) = sin(r) folds [-pi, pi] into [-pi/2, pi/2]; past pi by a rounding
+    // error the fold goes slightly negative, so flip the sign rather than copy it
+    float a = fminf(fabsf(r), PI_F - fabsf(r));
+    if (signbit(r)) a = -a;
+    float a2 = a * a;
+    return a + a * a2 * (SIN_C3 + a2 * (SIN_C5 + a2 * SIN_C7));
+}
+
+float WaveHeight(const WaveClock *clock, float x, float z) {
+    float height = 0.0f;
+    for (int w = 0; w < WAVE_COUNT; w++) {
+        height += waves[w].amplitude * FastSin(waves[w].kx * x + waves[w].kz * z + clock->phases[w]);
+    }
+    return height;
+}
+
+static void ComputeScalar(const WaveClock *clock, const float *x, const float *z, float *heights, int begin, int end) {
+    for (int i = begin; i < end; i++) heights[i] = WaveHeight(clock, x[i], z[i]);
+}
+
+#if defined(__x86_64__)
+static __m128 FastSin4(__m128 x) {
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 k = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(INV_TWO_PI))));
+    __m128 r = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(TWO_PI_HIGH))), _mm_mul_ps(k, _mm_set1_ps(TWO_PI_LOW)));
+    __m128 abs = _mm_andnot_ps(signMask, r);
+    __m128 a = _mm_min_ps(abs, _mm_sub_ps(_mm_set1_ps(PI_F), abs));
+    a = _mm_xor_ps(a, _mm_and_ps(signMask, r));
+    __m128 a2 = _mm_mul_ps(a, a);
+    __m128 poly = _mm_add_ps(_mm_set1_ps(SIN_C5), _mm_mul_ps(a2, _mm_set1_ps(SIN_C7)));
+    poly = _mm_add_ps(_mm_set1_ps(SIN_C3), _mm_mul_ps(a2, poly));
+    return _mm_add_ps(a, _mm_mul_ps(_mm_mul_ps(a, a2), poly));
+}
+
+// SSE2 is part of x86-64, so this path needs no check
+static int ComputeSse(const WaveClock *clock, const float *x, const float *z, float *heights, int count) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 px = _mm_loadu_ps(x + i), pz = _mm_loadu_ps(z + i);
+        __m128 height = _mm_setzero_ps();
+        for (int w = 0; w < WAVE_COUNT; w++) {
+            __m128 phase = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(waves[w].kx), px), _mm_mul_ps(_mm_set1_ps(waves[w].kz), pz)),
+                                      _mm_set1_ps(clock->phases[w]));
+            height = _mm_add_ps(height, _mm_mul_ps(_mm_set1_ps(waves[w].amplitude), FastSin4(phase)));
+        }
+        _mm_storeu_ps(heights + i, height);
+    }
+    return i;
+}
+
+__attribute__((target("avx"))) static __m256 FastSin8(__m256 x) {
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    __m256 k = _mm256_cvtepi32_ps(_mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(INV_TWO_PI))));
+    __m256 r = _mm256_sub_ps(_mm256_sub_ps(x, _mm256_mul_ps(k, _mm256_set1_ps(TWO_PI_HIGH))), _mm256_mul_ps(k, _mm256_set1_ps(TWO_PI_LOW)));
+    __m256 abs = _mm256_andnot_ps(signMask, r);
+    __m256 a = _mm256_min_ps(abs, _mm256_sub_ps(_mm256_set1_ps(PI_F), abs));
+    a = _mm256_xor_ps(a, _mm256_and_ps(signMask, r));
+    __m256 a2 = _mm256_mul_ps(a, a);
+    __m256 poly = _mm256_add_ps(_mm256_set1_ps(SIN_C5), _mm256_mul_ps(a2, _mm256_set1_ps(SIN_C7)));
+    poly = _mm256_add_ps(_mm256_set1_ps(SIN_C3), _mm256_mul_ps(a2, poly));
+    return _mm256_add_ps(a, _mm256_mul_ps(_mm256_mul_ps(a, a2), poly));
+}
+
+__attribute__((target("avx"))) static int ComputeAvx(const WaveClock *clock, const float *x, const float *z, float *heights, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 px = _mm256_loadu_ps(x + i), pz = _mm256_loadu_ps(z + i);
+        __m256 height = _mm256_setzero_ps();
+        for (int w = 0; w < WAVE_COUNT; w++) {
+            __m256 phase = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(waves[w].kx), px),
+                                                       _mm256_mul_ps(_mm256_set1_ps(waves[w].kz), pz)),
+                                         _mm256_set1_ps(clock->phases[w]));
+            height = _mm256_add_ps(height, _mm256_mul_ps(_mm256_set1_ps(waves[w].amplitude), FastSin8(phase)));
+        }
+        _mm256_storeu_ps(heights + i, height);
+    }
+    return i;
+}
+#endif
+
+void ComputeWaveHeights(const WaveClock *clock, const float *x, const float *z, float *heights, int count) {
+    int done = 0;
+#if defined(__x86_64__)
+    static int hasAvx = -1;
+    if (hasAvx < 0) hasAvx = __builtin_cpu_supports("avx");
+    done = hasAvx ? ComputeAvx(clock, x, z, heights, count) : ComputeSse(clock, x, z, heights, count);
+#endif
+    // Whatever is left over after the last full vector
+    ComputeScalar(clock, x, z, heights, done, count);
+}
@@ -0,0 +1,24 @@
+#ifndef WAVES_H
+#define WAVES_H
+
+// Sine waves summed into the water's height; see the table in waves.c
+#define WAVE_COUNT 3
+// Sum of the amplitudes, the furthest the surface moves from rest either way
+#define WAVE_MAX_HEIGHT 0.46f
+
+// Where each wave is in its cycle at one moment, shared by every height sample of a frame
+typedef struct {
+    float phases[WAVE_COUNT];
+} WaveClock;
+
+// Works out the phases in double precision so they stay smooth however long the game runs
+WaveClock GetWaveClock(double seconds);
+
+// Height of the water above its rest level at (x, z)
+float WaveHeight(const WaveClock *clock, float x, float z);
+
+// WaveHeight for count points stored as separate x and z arrays, eight or four at a
+// time with AVX or SSE when the CPU has them; every path gives the same heights
+void ComputeWaveHeights(const WaveClock *clock, const float *x, const float *z, float *heights, int count);
+
+#endif
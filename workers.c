@@ -0,0 +1,154 @@
+#include "workers.h"
+#include "profiler.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+int GetCoreCount(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+}
+
+static bool PushTask(WorkQueue *queue, int task) {
+    pthread_mutex_lock(&queue->mutex);
+    bool pushed = queue->count < queue->capacity;
+    if (pushed) queue->tasks[(queue->head + queue->count++) % queue->capacity] = task;
+    pthread_mutex_unlock(&queue->mutex);
+    return pushed;
+}
+
+// The owner takes the newest task, its data is the most likely to still be in cache
+static bool PopTask(WorkQueue *queue, int *task) {
+    pthread_mutex_lock(&queue->mutex);
+    bool popped = queue->count > 0;
+    if (popped) *task = queue->tasks[(queue->head + --queue->count) % queue->capacity];
+    pthread_mutex_unlock(&queue->mutex);
+    return popped;
+}
+
+// Thieves take the oldest task, the one that has waited longest behind the owner
+static bool StealTask(WorkQueue *queue, int *task) {
+    // Not worth waiting for a queue another thread is busy with, try the next one
+    if (pthread_mutex_trylock(&queue->mutex) != 0) return false;
+    bool stolen = queue->count > 0;
+    if (stolen) {
+        *task = queue->tasks[queue->head];
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count--;
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return stolen;
+}
+
+static bool FindTask(WorkerPool *pool, int self, int *task) {
+    if (PopTask(&pool->queues[self], task)) return true;
+    for (int i = 1; i < pool->threadCount; i++) {
+        if (StealTask(&pool->queues[(self + i) % pool->threadCount], task)) {
+            PROFILE_COUNT(COUNTER_TASKS_STOLEN, 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void *WorkerMain(void *args) {
+    WorkerThread *worker = (WorkerThread *)args;
+    WorkerPool *pool = worker->pool;
+
+    while (1) {
+        int task;
+        if (FindTask(pool, worker->index, &task)) {
+            atomic_fetch_sub(&pool->pending, 1);
+            pool->run(pool->context, task);
+
+            pthread_mutex_lock(&pool->mutex);
+            if (--pool->unfinished == 0) pthread_cond_broadcast(&pool->idle);
+            pthread_mutex_unlock(&pool->mutex);
+            continue;
+        }
+
+        // pending only goes up under the mutex, so a wakeup can't slip in between the check and the wait
+        pthread_mutex_lock(&pool->mutex);
+        while (atomic_load(&pool->pending) == 0 && !pool->stopping) pthread_cond_wait(&pool->wake, &pool->mutex);
+        bool done = pool->stopping && atomic_load(&pool->pending) == 0;
+        pthread_mutex_unlock(&pool->mutex);
+        if (done) break;
+    }
+    return NULL;
+}
+
+// Lets the first `started` workers finish the queue and frees everything
+static void ShutDownWorkers(WorkerPool *pool, int started) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < started; i++) pthread_join(pool->threads[i].thread, NULL);
+    for (int i = 0; i < pool->threadCount; i++) {
+        free(pool->queues[i].tasks);
+        pthread_mutex_destroy(&pool->queues[i].mutex);
+    }
+    free(pool->queues);
+    free(pool->threads);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->idle);
+    pthread_mutex_destroy(&pool->mutex);
+    memset(pool, 0, sizeof(*pool));
+}
+
+bool StartWorkerPool(WorkerPool *pool, int threadCount, int taskCapacity, WorkerTask run, void *context) {
+    memset(pool, 0, sizeof(*pool));
+    pool->threadCount = threadCount;
+    pool->run = run;
+    pool->context = context;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    pool->threads = calloc(threadCount, sizeof(WorkerThread));
+    pool->queues = calloc(threadCount, sizeof(WorkQueue));
+    for (int i = 0; i < threadCount; i++) {
+        pthread_mutex_init(&pool->queues[i].mutex, NULL);
+        pool->queues[i].tasks = malloc(taskCapacity * sizeof(int));
+        pool->queues[i].capacity = taskCapacity;
+    }
+
+    for (int i = 0; i < threadCount; i++) {
+        pool->threads[i].pool = pool;
+        pool->threads[i].index = i;
+        if (pthread_create(&pool->threads[i].thread, NULL, WorkerMain, &pool->threads[i]) != 0) {
+            ShutDownWorkers(pool, i);
+            return false;
+        }
+    }
+    return true;
+}
+
+void StopWorkerPool(WorkerPool *pool) {
+    if (pool->threads) ShutDownWorkers(pool, pool->threadCount);
+}
+
+void SubmitTask(WorkerPool *pool, int task) {
+    // Counted before it's queued, or a worker could steal and finish it first
+    // and let WaitForWorkers return with the task still owed
+    pthread_mutex_lock(&pool->mutex);
+    atomic_fetch_add(&pool->pending, 1);
+    pool->unfinished++;
+    pthread_mutex_unlock(&pool->mutex);
+
+    // Falls through to the next queue only if the caller queued more than taskCapacity
+    for (int i = 0; i < pool->threadCount; i++) {
+        if (PushTask(&pool->queues[(task + i) % pool->threadCount], task)) break;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pthread_cond_signal(&pool->wake);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void WaitForWorkers(WorkerPool *pool) {
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->unfinished > 0) pthread_cond_wait(&pool->idle, &pool->mutex);
+    pthread_mutex_unlock(&pool->mutex);
+}
@@ -0,0 +1,58 @@
+#ifndef WORKERS_H
+#define WORKERS_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// Runs task number `task` on one of the workers
+typedef void (*WorkerTask)(void *context, int task);
+
+// One worker's tasks; the owner pops the newest, thieves take the oldest
+typedef struct {
+    pthread_mutex_t mutex;
+    int *tasks;            // ring of capacity entries
+    int capacity;
+    int head;              // oldest task
+    int count;
+} WorkQueue;
+
+typedef struct {
+    struct WorkerPool *pool;
+    int index;             // its own queue
+    pthread_t thread;
+} WorkerThread;
+
+// Fixed set of threads running small integer tasks. Each worker has its own
+// queue and only touches the others when its own runs dry, so a worker stuck
+// on a heavy task doesn't hold up the light ones queued behind it.
+typedef struct WorkerPool {
+    int threadCount;
+    WorkerThread *threads;
+    WorkQueue *queues;
+    WorkerTask run;
+    void *context;
+
+    pthread_mutex_t mutex;     // guards sleeping, stopping and unfinished, not the queues
+    pthread_cond_t wake;
+    pthread_cond_t idle;       // signalled when unfinished drops to zero
+    _Atomic int pending;       // queued and not yet picked up
+    int unfinished;            // submitted and not yet run to the end
+    bool stopping;
+} WorkerPool;
+
+// Number of cores online, the default pool size
+int GetCoreCount(void);
+
+// Starts threadCount workers; taskCapacity bounds the tasks queued at once
+bool StartWorkerPool(WorkerPool *pool, int threadCount, int taskCapacity, WorkerTask run, void *context);
+// Runs whatever is still queued, then joins the workers
+void StopWorkerPool(WorkerPool *pool);
+
+// Queues the task on worker `task % threadCount`, so a task that is submitted
+// again and again tends to stay on the same core unless it gets stolen
+void SubmitTask(WorkerPool *pool, int task);
+// Blocks until every task submitted so far has finished running
+void WaitForWorkers(WorkerPool *pool);
+
+#endif